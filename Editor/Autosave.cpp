@@ -0,0 +1,272 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/Compression.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <cstdio>
+#include "Autosave.h"
+#include "SceneTab.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+namespace Urho3D
+{
+
+/// File id which starts recovery files.
+static const char* recoveryFileID = "UASV";
+/// Extension of recovery files.
+static const char* recoveryFileExtension = ".autosave";
+
+/// Data passed to a worker thread which writes recovery file.
+struct AutosaveJob
+{
+    /// Context used for accessing filesystem.
+    Context* context_ = nullptr;
+    /// Path to recovery file.
+    String fileName_;
+    /// Resource path of scene file.
+    String scenePath_;
+    /// Scene tab title.
+    String title_;
+    /// Uncompressed binary scene.
+    VectorBuffer snapshot_;
+};
+
+/// Compress snapshot to a temporary file and atomically replace recovery file with it, so a crash during the write
+/// never destroys previous recovery file. Runs on a worker thread and owns the job.
+static void WriteRecoveryFile(const WorkItem* item, unsigned threadIndex)
+{
+    auto* job = reinterpret_cast<AutosaveJob*>(item->aux_);
+    String tempFileName = job->fileName_ + ".tmp";
+
+    bool written;
+    {
+        File file(job->context_, tempFileName, FILE_WRITE);
+        written = file.IsOpen();
+        if (written)
+        {
+            file.WriteFileID(recoveryFileID);
+            file.WriteString(job->scenePath_);
+            file.WriteString(job->title_);
+            job->snapshot_.Seek(0);
+            written = CompressStream(file, job->snapshot_);
+        }
+    }
+
+    if (written)
+    {
+        String source = GetNativePath(tempFileName);
+        String destination = GetNativePath(job->fileName_);
+#ifdef _WIN32
+        written = MoveFileExW(WString(source).CString(), WString(destination).CString(),
+            MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        written = rename(source.CString(), destination.CString()) == 0;
+#endif
+    }
+
+    if (!written)
+        URHO3D_LOGERRORF("Writing recovery file %s failed", job->fileName_.CString());
+
+    delete job;
+}
+
+Autosave::Autosave(Context* context)
+    : Object(context)
+{
+    SetDirectory(GetFileSystem()->GetAppPreferencesDir("urho3d", "Editor") + "Autosave/");
+}
+
+Autosave::~Autosave()
+{
+    Complete();
+}
+
+void Autosave::SetDirectory(const String& directory)
+{
+    directory_ = AddTrailingSlash(directory);
+    GetFileSystem()->CreateDir(directory_);
+}
+
+void Autosave::Update(const Vector<SharedPtr<SceneTab>>& tabs)
+{
+    UpdatePendingWrites();
+
+    if (interval_ <= 0 || timer_.GetMSec(false) < (unsigned)(interval_ * 1000))
+        return;
+    timer_.Reset();
+
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    for (const auto& tab: tabs)
+    {
+        // Previous snapshot of this tab is still being written, tab is autosaved on next interval.
+        if (!tab->IsModified() || pendingWrites_.Contains(tab->GetID()))
+            continue;
+
+        auto it = autosavedRevisions_.Find(tab->GetID());
+        if (it != autosavedRevisions_.End() && it->second_ == tab->GetRevision())
+            continue;
+
+        auto* job = new AutosaveJob();
+        if (!tab->SaveSceneSnapshot(job->snapshot_))
+        {
+            delete job;
+            continue;
+        }
+        job->context_ = context_;
+        job->fileName_ = GetRecoveryFileName(tab->GetID());
+        job->scenePath_ = tab->GetScenePath();
+        job->title_ = tab->GetTitle();
+        autosavedRevisions_[tab->GetID()] = tab->GetRevision();
+
+        SharedPtr<WorkItem> item = workQueue->GetFreeItem();
+        item->workFunction_ = WriteRecoveryFile;
+        item->aux_ = job;
+        item->priority_ = 0;
+        item->sendEvent_ = false;
+
+        // Without worker threads queued items would wait for somebody to complete the queue.
+        if (workQueue->GetNumThreads() == 0)
+            WriteRecoveryFile(item, 0);
+        else
+        {
+            workQueue->AddWorkItem(item);
+            pendingWrites_[tab->GetID()].item_ = item;
+        }
+    }
+}
+
+void Autosave::Complete()
+{
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    for (auto it = pendingWrites_.Begin(); it != pendingWrites_.End(); it++)
+    {
+        // Items already picked up by worker threads are not waited for by WorkQueue::Complete().
+        const SharedPtr<WorkItem>& item = it->second_.item_;
+        while (!item->completed_)
+        {
+            workQueue->Complete(item->priority_);
+            Time::Sleep(0);
+        }
+    }
+    UpdatePendingWrites();
+}
+
+void Autosave::UpdatePendingWrites()
+{
+    for (auto it = pendingWrites_.Begin(); it != pendingWrites_.End();)
+    {
+        if (!it->second_.item_->completed_)
+        {
+            ++it;
+            continue;
+        }
+
+        if (it->second_.cancelled_)
+            DiscardFile(GetRecoveryFileName(it->first_));
+        it = pendingWrites_.Erase(it);
+    }
+}
+
+StringVector Autosave::GetRecoveryFiles() const
+{
+    StringVector files;
+    GetFileSystem()->ScanDir(files, directory_, String("*") + recoveryFileExtension, SCAN_FILES, false);
+    for (auto& fileName: files)
+        fileName = directory_ + fileName;
+    return files;
+}
+
+StringHash Autosave::GetRecoveryTabID(const String& fileName) const
+{
+    return StringHash(ToUInt(GetFileName(fileName), 16));
+}
+
+bool Autosave::Recover(const String& fileName, SceneTab* tab)
+{
+    File file(context_, fileName);
+    if (!file.IsOpen() || file.ReadFileID() != recoveryFileID)
+    {
+        URHO3D_LOGERRORF("%s is not a recovery file", fileName.CString());
+        return false;
+    }
+
+    String scenePath = file.ReadString();
+    String title = file.ReadString();
+    VectorBuffer snapshot;
+    if (!DecompressStream(snapshot, file))
+    {
+        URHO3D_LOGERRORF("Recovery file %s is damaged", fileName.CString());
+        return false;
+    }
+
+    snapshot.Seek(0);
+    if (!tab->LoadSceneSnapshot(snapshot, scenePath))
+        return false;
+
+    tab->SetTitle(title);
+    return true;
+}
+
+void Autosave::Discard(SceneTab* tab)
+{
+    autosavedRevisions_.Erase(tab->GetID());
+
+    auto it = pendingWrites_.Find(tab->GetID());
+    if (it != pendingWrites_.End() && !it->second_.item_->completed_)
+    {
+        // Write which did not start yet is dropped. Write in progress would recreate recovery file after it was
+        // removed, so file is removed once the write finishes.
+        SharedPtr<WorkItem> item = it->second_.item_;
+        if (!GetSubsystem<WorkQueue>()->RemoveWorkItem(item))
+        {
+            it->second_.cancelled_ = true;
+            return;
+        }
+        delete reinterpret_cast<AutosaveJob*>(item->aux_);
+    }
+    if (it != pendingWrites_.End())
+        pendingWrites_.Erase(it);
+
+    DiscardFile(GetRecoveryFileName(tab->GetID()));
+}
+
+void Autosave::DiscardFile(const String& fileName)
+{
+    if (GetFileSystem()->FileExists(fileName))
+        GetFileSystem()->Delete(fileName);
+}
+
+String Autosave::GetRecoveryFileName(StringHash tabID) const
+{
+    return directory_ + tabID.ToString() + recoveryFileExtension;
+}
+
+}
@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+
+
+namespace Urho3D
+{
+
+class SceneTab;
+
+/// Periodically saves modified scene tabs to recovery files. Scene snapshot is taken on the main thread, compression
+/// and writing to disk happen on a worker thread.
+class Autosave : public Object
+{
+    URHO3D_OBJECT(Autosave, Object);
+public:
+    /// Construct.
+    explicit Autosave(Context* context);
+    /// Destruct. Waits for pending writes.
+    ~Autosave() override;
+    /// Set directory where recovery files are stored.
+    void SetDirectory(const String& directory);
+    /// Set interval between autosaves in seconds. Zero disables autosave.
+    void SetInterval(float interval) { interval_ = interval; }
+    /// Return interval between autosaves in seconds.
+    float GetInterval() const { return interval_; }
+    /// Snapshot modified scene tabs when autosave interval elapses. Should be called once per frame.
+    void Update(const Vector<SharedPtr<SceneTab>>& tabs);
+    /// Wait until all pending recovery files are written.
+    void Complete();
+    /// Return recovery files left by previous session.
+    StringVector GetRecoveryFiles() const;
+    /// Return id of scene tab which recovery file belongs to.
+    StringHash GetRecoveryTabID(const String& fileName) const;
+    /// Load scene from recovery file into a scene tab.
+    bool Recover(const String& fileName, SceneTab* tab);
+    /// Remove recovery file of scene tab. Should be called when scene is saved or tab is closed. Does not wait for
+    /// recovery file being written, it is removed once writing finishes.
+    void Discard(SceneTab* tab);
+    /// Remove recovery file.
+    void DiscardFile(const String& fileName);
+
+protected:
+    /// Recovery file write of a single scene tab.
+    struct PendingWrite
+    {
+        /// Work item writing recovery file.
+        SharedPtr<WorkItem> item_;
+        /// Flag indicating that recovery file was discarded while it was written and should be removed afterwards.
+        bool cancelled_ = false;
+    };
+
+    /// Return path to recovery file of scene tab with specified id.
+    String GetRecoveryFileName(StringHash tabID) const;
+    /// Forget completed writes and remove recovery files which were discarded while being written.
+    void UpdatePendingWrites();
+
+    /// Directory where recovery files are stored.
+    String directory_;
+    /// Interval between autosaves in seconds.
+    float interval_ = 60.f;
+    /// Time since last autosave.
+    Timer timer_;
+    /// Scene tab revision at the moment of last autosave.
+    HashMap<StringHash, unsigned> autosavedRevisions_;
+    /// Queued recovery file writes mapped by scene tab id. Tab has at most one pending write.
+    HashMap<StringHash, PendingWrite> pendingWrites_;
+};
+
+}
@@ -0,0 +1,545 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Resource/JSONFile.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Toolbox/Scene/Prefab.h>
+#include "BatchProcessor.h"
+
+
+namespace Urho3D
+{
+
+/// State of one scene processed by BatchProcessor. Fields are written by one thread at a time: worker thread while
+/// its item is queued and main thread once the item is completed.
+struct BatchJob : public RefCounted
+{
+    /// Context used for accessing filesystem.
+    Context* context_ = nullptr;
+    /// Scene path as it was passed to batch processor.
+    String scenePath_;
+    /// Full path of scene file.
+    String fileName_;
+    /// Full path of saved scene file.
+    String outputFileName_;
+    /// Parsed xml scene.
+    SharedPtr<XMLFile> xml_;
+    /// Parsed json scene.
+    SharedPtr<JSONFile> json_;
+    /// Contents of binary scene file or serialized scene which is to be written.
+    VectorBuffer data_;
+    /// Reads and parses scene file.
+    SharedPtr<WorkItem> readItem_;
+    /// Writes saved scene.
+    SharedPtr<WorkItem> writeItem_;
+    /// Flag indicating that scene file was read and parsed.
+    bool parsed_ = false;
+    /// Flag indicating that saved scene was written.
+    bool written_ = false;
+    /// Flag indicating that scene failed to load, validate or save.
+    bool failed_ = false;
+    /// Time spent reading and parsing the file in microseconds.
+    long long readTime_ = 0;
+    /// Time spent instantiating the scene in microseconds.
+    long long loadTime_ = 0;
+    /// Time spent validating resource references in microseconds.
+    long long validateTime_ = 0;
+    /// Time spent serializing the scene in microseconds.
+    long long saveTime_ = 0;
+    /// Time spent writing the file in microseconds.
+    long long writeTime_ = 0;
+};
+
+/// Read scene file and parse it if it is xml or json. Runs on a worker thread.
+static void ReadSceneFile(const WorkItem* item, unsigned threadIndex)
+{
+    auto* job = reinterpret_cast<BatchJob*>(item->aux_);
+    HiresTimer timer;
+
+    File file(job->context_, job->fileName_);
+    if (file.IsOpen())
+    {
+        if (job->fileName_.EndsWith(".xml", false))
+        {
+            job->xml_ = new XMLFile(job->context_);
+            job->parsed_ = job->xml_->Load(file);
+        }
+        else if (job->fileName_.EndsWith(".json", false))
+        {
+            job->json_ = new JSONFile(job->context_);
+            job->parsed_ = job->json_->Load(file);
+        }
+        else
+        {
+            job->data_.SetData(file, file.GetSize());
+            job->parsed_ = job->data_.GetSize() == file.GetSize();
+        }
+    }
+
+    job->readTime_ = timer.GetUSec(false);
+}
+
+/// Write serialized scene to output file. Runs on a worker thread.
+static void WriteSceneFile(const WorkItem* item, unsigned threadIndex)
+{
+    auto* job = reinterpret_cast<BatchJob*>(item->aux_);
+    HiresTimer timer;
+
+    File file(job->context_, job->outputFileName_, FILE_WRITE);
+    job->written_ = file.IsOpen() && file.Write(job->data_.GetData(), job->data_.GetSize()) == job->data_.GetSize();
+
+    job->writeTime_ = timer.GetUSec(false);
+}
+
+/// Queue work item or execute it right away if there are no worker threads.
+static SharedPtr<WorkItem> QueueJob(WorkQueue* workQueue, BatchJob* job, void (*workFunction)(const WorkItem*, unsigned))
+{
+    SharedPtr<WorkItem> item = workQueue->GetFreeItem();
+    item->workFunction_ = workFunction;
+    item->aux_ = job;
+    item->priority_ = 0;
+    item->sendEvent_ = false;
+
+    if (workQueue->GetNumThreads() == 0)
+    {
+        workFunction(item, 0);
+        item->completed_ = true;
+    }
+    else
+        workQueue->AddWorkItem(item);
+    return item;
+}
+
+/// Wait until work item is completed.
+static void WaitForItem(WorkQueue* workQueue, WorkItem* item)
+{
+    // Items already picked up by worker threads are not waited for by WorkQueue::Complete().
+    while (!item->completed_)
+    {
+        workQueue->Complete(item->priority_);
+        Time::Sleep(0);
+    }
+}
+
+/// Create directory and all its missing parents.
+static bool CreateDirs(FileSystem* fileSystem, const String& directory)
+{
+    String path = AddTrailingSlash(directory);
+    for (unsigned i = path.Find('/', 1); i != String::NPOS; i = path.Find('/', i + 1))
+    {
+        String parent = path.Substring(0, i + 1);
+        if (!fileSystem->DirExists(parent) && !fileSystem->CreateDir(parent))
+            return false;
+    }
+    return true;
+}
+
+/// Extensions of supported scene formats.
+static const StringVector sceneFormats = {".xml", ".json", ".bin"};
+/// Number of times every scene is saved and loaded in each format when benchmarking.
+static const unsigned benchmarkIterations = 5;
+
+/// Format time in microseconds as milliseconds.
+static String FormatTime(long long usec)
+{
+    return ToString("%.1f ms", usec / 1000.0);
+}
+
+BatchProcessor::BatchProcessor(Context* context)
+    : Object(context)
+{
+}
+
+bool BatchProcessor::ParseArguments(const StringVector& arguments)
+{
+    bool batch = false;
+    for (unsigned i = 0; i < arguments.Size(); i++)
+    {
+        const String& argument = arguments[i];
+        bool hasValue = i + 1 < arguments.Size();
+        if (argument == "-batch")
+            batch = true;
+        else if (argument == "-project" && hasValue)
+            AddProject(arguments[++i]);
+        else if (argument == "-format" && hasValue)
+        {
+            outputFormat_ = "." + arguments[++i].ToLower();
+            saveEnabled_ = true;
+        }
+        else if (argument == "-resave")
+            saveEnabled_ = true;
+        else if (argument == "-benchmark")
+            benchmarkEnabled_ = true;
+        else if (argument == "-output" && hasValue)
+            outputDirectory_ = arguments[++i];
+        else if (argument.EndsWith(".xml", false) || argument.EndsWith(".json", false) ||
+            argument.EndsWith(".bin", false))
+            AddScene(argument);
+    }
+    return batch;
+}
+
+void BatchProcessor::AddScene(const String& filePath)
+{
+    scenes_.Push(filePath);
+}
+
+bool BatchProcessor::AddProject(const String& filePath)
+{
+    SharedPtr<XMLFile> xml(new XMLFile(context_));
+    File file(context_, filePath);
+    if (!file.IsOpen() || !xml->Load(file))
+    {
+        URHO3D_LOGERRORF("Loading project %s failed. Only xml projects can be processed in batch mode.",
+            filePath.CString());
+        return false;
+    }
+
+    auto scene = xml->GetRoot().GetChild("scenes").GetChild("scene");
+    while (scene.NotNull())
+    {
+        String path = scene.GetAttribute("path");
+        if (!path.Empty())
+            AddScene(path);
+        scene = scene.GetNext("scene");
+    }
+    return true;
+}
+
+unsigned BatchProcessor::Run()
+{
+    if (!outputFormat_.Empty() && !sceneFormats.Contains(outputFormat_))
+    {
+        URHO3D_LOGERRORF("Unknown scene format %s", outputFormat_.CString());
+        return scenes_.Size();
+    }
+
+    auto* fileSystem = GetSubsystem<FileSystem>();
+    auto* cache = GetSubsystem<ResourceCache>();
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    HiresTimer totalTimer;
+    unsigned failed = 0;
+
+    // All scene files are read and parsed in parallel while main thread instantiates scenes that are already parsed.
+    Vector<SharedPtr<BatchJob>> jobs;
+    HashSet<String> outputFileNames;
+    for (const String& scenePath: scenes_)
+    {
+        SharedPtr<BatchJob> job(new BatchJob());
+        job->context_ = context_;
+        job->scenePath_ = scenePath;
+        job->fileName_ = IsAbsolutePath(scenePath) ? scenePath : cache->GetResourceFileName(scenePath);
+        if (job->fileName_.Empty() || !sceneFormats.Contains(GetExtension(job->fileName_)))
+        {
+            URHO3D_LOGERRORF("Scene %s does not exist or has unknown format", scenePath.CString());
+            failed++;
+            continue;
+        }
+
+        if (saveEnabled_)
+        {
+            String extension = outputFormat_.Empty() ? GetExtension(job->fileName_) : outputFormat_;
+            if (outputDirectory_.Empty())
+                job->outputFileName_ = ReplaceExtension(job->fileName_, extension);
+            else
+            {
+                // Directory structure of resources is kept, otherwise scenes with the same name would overwrite each
+                // other.
+                job->outputFileName_ = AddTrailingSlash(outputDirectory_) +
+                    ReplaceExtension(GetRelativeScenePath(scenePath, job->fileName_), extension);
+                CreateDirs(fileSystem, GetPath(job->outputFileName_));
+            }
+
+            // Scenes may still collide, eg. when absolute paths from different directories are passed or when scenes
+            // differing only by extension are converted to one format.
+            if (outputFileNames.Contains(job->outputFileName_.ToLower()))
+            {
+                URHO3D_LOGERRORF("Scene %s would overwrite another scene saved to %s", scenePath.CString(),
+                    job->outputFileName_.CString());
+                failed++;
+                continue;
+            }
+            outputFileNames.Insert(job->outputFileName_.ToLower());
+        }
+
+        job->readItem_ = QueueJob(workQueue, job, ReadSceneFile);
+        jobs.Push(job);
+    }
+
+    // Components of engine do not keep names of resources that failed to load, such references are caught while
+    // scene is loading instead.
+    SubscribeToEvent(E_RESOURCENOTFOUND, [&](StringHash, VariantMap& args) {
+        failedResources_.Insert(args[ResourceNotFound::P_RESOURCENAME].GetString());
+    });
+    SubscribeToEvent(E_LOADFAILED, [&](StringHash, VariantMap& args) {
+        failedResources_.Insert(args[LoadFailed::P_RESOURCENAME].GetString());
+    });
+
+    for (auto& job: jobs)
+    {
+        WaitForItem(workQueue, job->readItem_);
+        job->readItem_.Reset();
+        if (!job->parsed_)
+        {
+            URHO3D_LOGERRORF("Reading scene %s failed", job->scenePath_.CString());
+            job->failed_ = true;
+            continue;
+        }
+
+        HiresTimer timer;
+        failedResources_.Clear();
+        SharedPtr<Scene> scene(new Scene(context_));
+        bool loaded;
+        if (job->xml_.NotNull())
+            loaded = scene->LoadXML(job->xml_->GetRoot());
+        else if (job->json_.NotNull())
+            loaded = scene->LoadJSON(job->json_->GetRoot());
+        else
+            loaded = scene->Load(job->data_);
+        job->xml_.Reset();
+        job->json_.Reset();
+        job->data_.Clear();
+        job->loadTime_ = timer.GetUSec(true);
+
+        if (!loaded)
+        {
+            URHO3D_LOGERRORF("Loading scene %s failed", job->scenePath_.CString());
+            job->failed_ = true;
+            continue;
+        }
+
+        for (const String& resourceName: failedResources_)
+            URHO3D_LOGERRORF("%s: resource %s failed to load", job->scenePath_.CString(), resourceName.CString());
+        job->failed_ = !failedResources_.Empty();
+        job->failed_ |= ValidateResources(scene, job->scenePath_) > 0;
+        job->validateTime_ = timer.GetUSec(true);
+
+        if (benchmarkEnabled_)
+        {
+            BenchmarkFormats(scene, job->scenePath_);
+            timer.Reset();
+        }
+
+        if (saveEnabled_)
+        {
+            bool saved;
+            PrefabReference::SetContentTemporary(scene, true);
+            if (job->outputFileName_.EndsWith(".xml", false))
+                saved = scene->SaveXML(job->data_);
+            else if (job->outputFileName_.EndsWith(".json", false))
+                saved = scene->SaveJSON(job->data_);
+            else
+                saved = scene->Save(job->data_);
+            PrefabReference::SetContentTemporary(scene, false);
+            job->saveTime_ = timer.GetUSec(true);
+
+            if (saved)
+                job->writeItem_ = QueueJob(workQueue, job, WriteSceneFile);
+            else
+            {
+                URHO3D_LOGERRORF("Saving scene %s failed", job->scenePath_.CString());
+                job->failed_ = true;
+            }
+        }
+    }
+
+    UnsubscribeFromEvent(E_RESOURCENOTFOUND);
+    UnsubscribeFromEvent(E_LOADFAILED);
+    failedResources_.Clear();
+
+    long long readTime = 0, loadTime = 0, validateTime = 0, saveTime = 0, writeTime = 0;
+    for (auto& job: jobs)
+    {
+        if (job->writeItem_.NotNull())
+        {
+            WaitForItem(workQueue, job->writeItem_);
+            job->writeItem_.Reset();
+            if (!job->written_)
+            {
+                URHO3D_LOGERRORF("Writing scene %s failed", job->outputFileName_.CString());
+                job->failed_ = true;
+            }
+        }
+        if (job->failed_)
+            failed++;
+
+        PrintLine(ToString("%s: read %s, load %s, validate %s, save %s, write %s", job->scenePath_.CString(),
+            FormatTime(job->readTime_).CString(), FormatTime(job->loadTime_).CString(),
+            FormatTime(job->validateTime_).CString(), FormatTime(job->saveTime_).CString(),
+            FormatTime(job->writeTime_).CString()));
+
+        readTime += job->readTime_;
+        loadTime += job->loadTime_;
+        validateTime += job->validateTime_;
+        saveTime += job->saveTime_;
+        writeTime += job->writeTime_;
+    }
+
+    // Read and write times are summed over worker threads and may exceed total time.
+    PrintLine(ToString("Processed %u scenes, %u failed. Total %s: read %s, load %s, validate %s, save %s, write %s",
+        scenes_.Size(), failed, FormatTime(totalTimer.GetUSec(false)).CString(), FormatTime(readTime).CString(),
+        FormatTime(loadTime).CString(), FormatTime(validateTime).CString(), FormatTime(saveTime).CString(),
+        FormatTime(writeTime).CString()));
+
+    if (benchmarkEnabled_ && !jobs.Empty())
+    {
+        for (const String& format: sceneFormats)
+        {
+            auto it = benchmarkTotals_.Find(format);
+            if (it == benchmarkTotals_.End())
+                continue;
+            PrintLine(ToString("Total %s: save %s, load %s, size %llu bytes", format.CString(),
+                FormatTime(it->second_.saveTime_).CString(), FormatTime(it->second_.loadTime_).CString(),
+                it->second_.size_));
+        }
+        benchmarkTotals_.Clear();
+    }
+
+    return failed;
+}
+
+void BatchProcessor::BenchmarkFormats(Scene* scene, const String& scenePath)
+{
+    // Benchmark measures scene data as it is saved to files, prefab contents are not included.
+    PrefabReference::SetContentTemporary(scene, true);
+    for (const String& format: sceneFormats)
+    {
+        FormatBenchmark result;
+        bool succeeded = true;
+        for (unsigned i = 0; i < benchmarkIterations && succeeded; i++)
+        {
+            VectorBuffer buffer;
+            HiresTimer timer;
+            if (format == ".xml")
+                succeeded = scene->SaveXML(buffer);
+            else if (format == ".json")
+                succeeded = scene->SaveJSON(buffer);
+            else
+                succeeded = scene->Save(buffer);
+            result.saveTime_ += timer.GetUSec(true);
+            result.size_ = buffer.GetSize();
+
+            // Loading includes parsing of text formats, because in-memory documents are not reused by the editor.
+            buffer.Seek(0);
+            SharedPtr<Scene> loadedScene(new Scene(context_));
+            timer.Reset();
+            if (format == ".xml")
+            {
+                SharedPtr<XMLFile> xml(new XMLFile(context_));
+                succeeded &= xml->Load(buffer) && loadedScene->LoadXML(xml->GetRoot());
+            }
+            else if (format == ".json")
+            {
+                SharedPtr<JSONFile> json(new JSONFile(context_));
+                succeeded &= json->Load(buffer) && loadedScene->LoadJSON(json->GetRoot());
+            }
+            else
+                succeeded &= loadedScene->Load(buffer);
+            result.loadTime_ += timer.GetUSec(false);
+        }
+
+        if (!succeeded)
+        {
+            URHO3D_LOGERRORF("%s: benchmark of %s format failed", scenePath.CString(), format.CString());
+            continue;
+        }
+
+        result.saveTime_ /= benchmarkIterations;
+        result.loadTime_ /= benchmarkIterations;
+        PrintLine(ToString("%s: %s save %s, load %s, size %llu bytes", scenePath.CString(), format.CString(),
+            FormatTime(result.saveTime_).CString(), FormatTime(result.loadTime_).CString(), result.size_));
+
+        FormatBenchmark& total = benchmarkTotals_[format];
+        total.saveTime_ += result.saveTime_;
+        total.loadTime_ += result.loadTime_;
+        total.size_ += result.size_;
+    }
+    PrefabReference::SetContentTemporary(scene, false);
+}
+
+unsigned BatchProcessor::ValidateResources(Scene* scene, const String& scenePath)
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+    unsigned missing = 0;
+    auto validate = [&](Serializable* serializable, Node* node, const String& resourceName) {
+        // Resources that failed to load are already reported.
+        if (resourceName.Empty() || failedResources_.Contains(resourceName) || cache->Exists(resourceName))
+            return;
+        URHO3D_LOGERRORF("%s: %s of node %u (%s) references missing resource %s", scenePath.CString(),
+            serializable->GetTypeName().CString(), node->GetID(), node->GetName().CString(), resourceName.CString());
+        missing++;
+    };
+
+    PODVector<Node*> nodes;
+    scene->GetChildren(nodes, true);
+    nodes.Push(scene);
+    for (Node* node: nodes)
+    {
+        for (auto& component: node->GetComponents())
+        {
+            const Vector<AttributeInfo>* attributes = component->GetAttributes();
+            if (attributes == nullptr)
+                continue;
+
+            for (unsigned i = 0; i < attributes->Size(); i++)
+            {
+                VariantType type = attributes->At(i).type_;
+                if (type == VAR_RESOURCEREF)
+                    validate(component, node, component->GetAttribute(i).GetResourceRef().name_);
+                else if (type == VAR_RESOURCEREFLIST)
+                {
+                    Variant value = component->GetAttribute(i);
+                    for (const String& name: value.GetResourceRefList().names_)
+                        validate(component, node, name);
+                }
+            }
+        }
+    }
+    return missing;
+}
+
+String BatchProcessor::GetRelativeScenePath(const String& scenePath, const String& fileName) const
+{
+    if (!IsAbsolutePath(scenePath))
+        return scenePath;
+
+    for (const String& directory: GetSubsystem<ResourceCache>()->GetResourceDirs())
+    {
+        if (fileName.StartsWith(directory, false))
+            return fileName.Substring(directory.Length());
+    }
+    return GetFileNameAndExtension(fileName);
+}
+
+}
@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Core/Object.h>
+
+
+namespace Urho3D
+{
+
+class Scene;
+
+/// Loads scenes without rendering, validates resources they reference and optionally resaves them in the same or
+/// another format. Reading, parsing and writing of scene files happen on worker threads. Scenes are instantiated and
+/// serialized on the main thread, because loading components requests resources from resource cache.
+class BatchProcessor : public Object
+{
+    URHO3D_OBJECT(BatchProcessor, Object);
+public:
+    /// Construct.
+    explicit BatchProcessor(Context* context);
+    /// Parse command line arguments. Returns true if batch mode was requested with -batch. Recognized options are
+    /// -project <file> (scenes of xml project), -format <xml|json|bin> (convert scenes), -resave (save scenes in their
+    /// own format), -output <directory> and -benchmark (compare scene formats). Any other argument ending with .xml, .json or .bin is a scene to process.
+    bool ParseArguments(const StringVector& arguments);
+    /// Add scene file to process. Path is a resource name or an absolute path.
+    void AddScene(const String& filePath);
+    /// Add all scenes of xml project file.
+    bool AddProject(const String& filePath);
+    /// Set extension of converted scenes. Empty extension saves scenes in their own format.
+    void SetOutputFormat(const String& extension) { outputFormat_ = extension; }
+    /// Set directory where saved scenes are written. Scenes keep their path relative to resource directory. When empty
+    /// scenes are saved next to source files.
+    void SetOutputDirectory(const String& directory) { outputDirectory_ = directory; }
+    /// Enable or disable saving of processed scenes. When disabled scenes are only validated.
+    void SetSaveEnabled(bool enable) { saveEnabled_ = enable; }
+    /// Enable or disable measuring of save and load times and sizes of every scene in all supported formats.
+    void SetBenchmarkEnabled(bool enable) { benchmarkEnabled_ = enable; }
+    /// Process all added scenes and print timing statistics. Returns number of scenes that failed to load, validate
+    /// or save.
+    unsigned Run();
+
+protected:
+    /// Average measurements of one scene format.
+    struct FormatBenchmark
+    {
+        /// Time spent serializing the scene in microseconds.
+        long long saveTime_ = 0;
+        /// Time spent parsing and instantiating the scene in microseconds.
+        long long loadTime_ = 0;
+        /// Size of serialized scene in bytes.
+        unsigned long long size_ = 0;
+    };
+
+    /// Log references to resources that do not exist. Returns number of missing resources.
+    unsigned ValidateResources(Scene* scene, const String& scenePath);
+    /// Save scene to memory and load it back in every supported format and print average times and sizes. Resources
+    /// are already cached, so load times do not include resource loading.
+    void BenchmarkFormats(Scene* scene, const String& scenePath);
+    /// Return path of scene relative to resource directory it is in. Scenes outside of resource directories return
+    /// file name only.
+    String GetRelativeScenePath(const String& scenePath, const String& fileName) const;
+
+    /// Scenes to process.
+    StringVector scenes_;
+    /// Extension of saved scenes.
+    String outputFormat_;
+    /// Directory of saved scenes.
+    String outputDirectory_;
+    /// Flag indicating that processed scenes are saved.
+    bool saveEnabled_ = false;
+    /// Flag indicating that scene formats are benchmarked.
+    bool benchmarkEnabled_ = false;
+    /// Save times, load times and sizes of all benchmarked scenes summed per format.
+    HashMap<String, FormatBenchmark> benchmarkTotals_;
+    /// Names of resources that were not found or failed to load while current scene was loading.
+    HashSet<String> failedResources_;
+};
+
+}
@@ -22,6 +22,7 @@
 
 #include "Editor.h"
 #include "EditorEvents.h"
+#include "EffectCatalog.h"
 #include "SceneTab.h"
 #include "SceneSettings.h"
 #include <imgui/imgui_internal.h>
@@ -40,6 +41,13 @@ URHO3D_DEFINE_APPLICATION_MAIN(Editor);
 namespace Urho3D
 {
 
+/// File id which starts binary project files.
+static const char* projectFileID = "UPRJ";
+/// Version of binary project file format. Increment when layout of binary project changes.
+static const unsigned projectFormatVersion = 2;
+/// Time in milliseconds per frame shared by all scenes that are loading asynchronously.
+static const int sceneLoadingBudgetMs = 8;
+
 Editor::Editor(Context* context)
     : Application(context)
 {
@@ -68,12 +76,33 @@ void Editor::Setup()
     engineParameters_[EP_LOG_LEVEL] = LOG_DEBUG;
     engineParameters_[EP_WINDOW_RESIZABLE] = true;
     engineParameters_[EP_RESOURCE_PATHS] = "CoreData;Data;EditorData";
+
+    // Batch mode processes scenes without opening a window, so it can run on machines without gpu.
+    batch_ = new BatchProcessor(context_);
+    if (batch_->ParseArguments(GetArguments()))
+    {
+        engineParameters_[EP_HEADLESS] = true;
+        engineParameters_[EP_LOG_LEVEL] = LOG_INFO;
+    }
+    else
+        batch_.Reset();
 }
 
 void Editor::Start()
 {
     Context::SetContext(context_);
 
+    if (batch_.NotNull())
+    {
+        // Scenes may contain toolbox components, like prefab references.
+        RegisterToolboxTypes(context_);
+        // ErrorExit() would show a message box, failures are already logged.
+        if (batch_->Run() > 0)
+            exitCode_ = EXIT_FAILURE;
+        engine_->Exit();
+        return;
+    }
+
     context_->RegisterFactory<SystemUI>();
     context_->RegisterSubsystem(new SystemUI(context_));
 
@@ -86,6 +115,10 @@ void Editor::Start()
     context_->RegisterSubsystem(this);
 
     SceneSettings::RegisterObject(context_);
+    context_->RegisterSubsystem(new EffectCatalog(context_));
+    context_->RegisterSubsystem(new NodeClipboard(context_));
+    context_->RegisterSubsystem(new PrefabCache(context_));
+    context_->RegisterSubsystem(new ModelBVHCache(context_));
 
     GetSubsystem<SystemUI>()->ApplyStyleDefault(true, 1.0f);
     GetSubsystem<SystemUI>()->AddFont("Fonts/fontawesome-webfont.ttf", 0, {ICON_MIN_FA, ICON_MAX_FA, 0}, true);
@@ -100,10 +133,17 @@ void Editor::Start()
     LoadProject("Etc/DefaultEditorProject.xml");
     // Prevent overwriting example scene.
     sceneTabs_.Front()->ClearCachedPaths();
+
+    autosave_ = new Autosave(context_);
+    recoveryFiles_ = autosave_->GetRecoveryFiles();
 }
 
 void Editor::Stop()
 {
+    if (batch_.NotNull())
+        return;
+
+    autosave_->Complete();
     SaveProject(projectFilePath_);
     ui::ShutdownDock();
 }
@@ -113,8 +153,28 @@ void Editor::SaveProject(const String& filePath)
     if (filePath.Empty())
         return;
 
-    SharedPtr<XMLFile> xml(new XMLFile(context_));
-    XMLElement root = xml->CreateRoot("project");
+    // Xml is meant for diffable exports, everything else is saved in compact binary format.
+    bool saved;
+    if (GetExtension(filePath) == ".xml")
+    {
+        SharedPtr<XMLFile> xml(new XMLFile(context_));
+        SaveProject(xml->CreateRoot("project"));
+        saved = xml->SaveFile(filePath);
+    }
+    else
+    {
+        File file(context_, filePath, FILE_WRITE);
+        saved = file.IsOpen();
+        if (saved)
+            SaveProject(file);
+    }
+
+    if (!saved)
+        URHO3D_LOGERRORF("Saving project to %s failed", filePath.CString());
+}
+
+void Editor::SaveProject(XMLElement root)
+{
     root.SetAttribute("version", "0");
 
     auto window = root.CreateChild("window");
@@ -128,9 +188,22 @@ void Editor::SaveProject(const String& filePath)
         sceneTab->SaveProject(scenes.CreateChild("scene"));
 
     ui::SaveDock(root.CreateChild("docks"));
+}
 
-    if (!xml->SaveFile(filePath))
-        URHO3D_LOGERRORF("Saving project to %s failed", filePath.CString());
+void Editor::SaveProject(Serializer& dest)
+{
+    dest.WriteFileID(projectFileID);
+    dest.WriteUInt(projectFormatVersion);
+
+    dest.WriteInt(GetGraphics()->GetWidth());
+    dest.WriteInt(GetGraphics()->GetHeight());
+    dest.WriteIntVector2(GetGraphics()->GetWindowPosition());
+
+    dest.WriteVLE(sceneTabs_.Size());
+    for (auto& sceneTab: sceneTabs_)
+        sceneTab->SaveProject(dest);
+
+    ui::SaveDock(dest);
 }
 
 void Editor::LoadProject(const String& filePath)
@@ -138,18 +211,30 @@ void Editor::LoadProject(const String& filePath)
     if (filePath.Empty())
         return;
 
-    SharedPtr<XMLFile> xml;
+    SharedPtr<File> file;
     if (!IsAbsolutePath(filePath))
-        xml = GetCache()->GetResource<XMLFile>(filePath);
+        file = GetCache()->GetFile(filePath, false);
+
+    if (file.Null())
+        file = new File(context_, filePath);
 
-    if (xml.Null())
+    if (!file->IsOpen())
+        return;
+
+    // Format is detected from file contents, extension does not matter.
+    if (file->ReadFileID() == projectFileID)
+        LoadProject(*file);
+    else
     {
-        xml = new XMLFile(context_);
-        if (!xml->LoadFile(filePath))
-            return;
+        file->Seek(0);
+        SharedPtr<XMLFile> xml(new XMLFile(context_));
+        if (xml->Load(*file))
+            LoadProject(xml->GetRoot());
     }
+}
 
-    auto root = xml->GetRoot();
+void Editor::LoadProject(XMLElement root)
+{
     if (root.NotNull())
     {
         idPool_.Clear();
@@ -176,6 +261,29 @@ void Editor::LoadProject(const String& filePath)
     }
 }
 
+void Editor::LoadProject(Deserializer& source)
+{
+    unsigned version = source.ReadUInt();
+    if (version != projectFormatVersion)
+    {
+        URHO3D_LOGERRORF("Project %s has unsupported format version %u", source.GetName().CString(), version);
+        return;
+    }
+
+    idPool_.Clear();
+    int width = source.ReadInt();
+    int height = source.ReadInt();
+    IntVector2 position = source.ReadIntVector2();
+    GetGraphics()->SetMode(width, height);
+    GetGraphics()->SetWindowPosition(position);
+
+    sceneTabs_.Clear();
+    for (unsigned i = 0, count = source.ReadVLE(); i < count && !source.IsEof(); i++)
+        CreateNewScene(source);
+
+    ui::LoadDock(source);
+}
+
 void Editor::OnUpdate(VariantMap& args)
 {
     ui::RootDock({0, 20}, ui::GetIO().DisplaySize - ImVec2(0, 20));
@@ -211,7 +319,10 @@ void Editor::OnUpdate(VariantMap& args)
             ++it;
         }
         else
+        {
+            autosave_->Discard(tab);
             it = sceneTabs_.Erase(it);
+        }
     }
 
 
@@ -224,6 +335,18 @@ void Editor::OnUpdate(VariantMap& args)
     }
     ui::EndDock();
 
+    if (statisticsWindowOpen_)
+    {
+        if (!activeTab_.Expired())
+            ui::SetNextDockPos(activeTab_->GetUniqueTitle().CString(), ui::Slot_Right, ImGuiCond_FirstUseEver);
+        if (ui::BeginDock("Statistics", &statisticsWindowOpen_))
+        {
+            if (!activeTab_.Expired())
+                activeTab_->RenderStatistics();
+        }
+        ui::EndDock();
+    }
+
     String selected;
     if (sceneTabs_.Size())
         ui::SetNextDockPos(sceneTabs_.Back()->GetUniqueTitle().CString(), ui::Slot_Bottom, ImGuiCond_FirstUseEver);
@@ -234,6 +357,94 @@ void Editor::OnUpdate(VariantMap& args)
         {
             CreateNewScene()->LoadScene(selected);
         }
+        else if (type == CTYPE_SCENEOBJECT && !activeTab_.Expired())
+            activeTab_->InstantiatePrefab(selected);
+    }
+
+    UpdateSceneLoading();
+    autosave_->Update(sceneTabs_);
+    RenderRecoveryPopup();
+}
+
+void Editor::UpdateSceneLoading()
+{
+    // Deferred scene loads are started one per frame, focused tab first. Editor stays responsive while project is
+    // loading and every tab becomes usable as soon as its own scene is loaded.
+    SceneTab* nextLoad = nullptr;
+    if (!activeTab_.Expired() && activeTab_->IsLoadPending())
+        nextLoad = activeTab_;
+
+    int numLoading = 0;
+    for (auto& tab: sceneTabs_)
+    {
+        if (nextLoad == nullptr && tab->IsLoadPending())
+            nextLoad = tab;
+        tab->UpdateLoading();
+        if (tab->GetScene()->IsAsyncLoading())
+            numLoading++;
+    }
+
+    if (nextLoad != nullptr)
+    {
+        nextLoad->StartPendingLoad();
+        if (nextLoad->GetScene()->IsAsyncLoading())
+            numLoading++;
+    }
+
+    // Scenes are loaded concurrently and split loading time equally instead of each taking a full time slice.
+    for (auto& tab: sceneTabs_)
+    {
+        if (tab->GetScene()->IsAsyncLoading())
+            tab->GetScene()->SetAsyncLoadingMs(Max(1, sceneLoadingBudgetMs / numLoading));
+    }
+}
+
+void Editor::RenderRecoveryPopup()
+{
+    if (recoveryFiles_.Empty())
+        return;
+
+    const char* title = "Recover Scenes";
+    if (!ui::IsPopupOpen(title))
+        ui::OpenPopup(title);
+
+    if (ui::BeginPopupModal(title, nullptr, ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        // Recovery files also remain after editor was closed without saving changes, not only after a crash.
+        ui::TextUnformatted("Unsaved changes of following scenes from previous session can be recovered:");
+        for (const auto& fileName: recoveryFiles_)
+            ui::BulletText("%s", GetFileNameAndExtension(fileName).CString());
+
+        bool recover = ui::Button("Recover");
+        ui::SameLine();
+        bool discard = ui::Button("Discard");
+
+        if (recover)
+        {
+            for (const auto& fileName: recoveryFiles_)
+            {
+                StringHash id = autosave_->GetRecoveryTabID(fileName);
+                SceneTab* tab = nullptr;
+                for (auto& sceneTab: sceneTabs_)
+                {
+                    if (sceneTab->GetID() == id)
+                        tab = sceneTab;
+                }
+                if (tab == nullptr)
+                    tab = CreateNewScene();
+                autosave_->Recover(fileName, tab);
+            }
+        }
+
+        if (recover || discard)
+        {
+            // Recovered scenes are autosaved again under ids of their tabs.
+            for (const auto& fileName: recoveryFiles_)
+                autosave_->DiscardFile(fileName);
+            recoveryFiles_.Clear();
+            ui::CloseCurrentPopup();
+        }
+        ui::EndPopup();
     }
 }
 
@@ -253,8 +464,8 @@ void Editor::RenderMenuBar()
 
             if (ui::MenuItem("Open Project"))
             {
-                const char* patterns[] = {"*.xml"};
-                projectFilePath_ = tinyfd_openFileDialog("Open Project", ".", 1, patterns, "XML Files", 0);
+                const char* patterns[] = {"*.project", "*.xml"};
+                projectFilePath_ = tinyfd_openFileDialog("Open Project", ".", 2, patterns, "Project Files", 0);
                 LoadProject(projectFilePath_);
             }
 
@@ -271,6 +482,51 @@ void Editor::RenderMenuBar()
             ui::EndMenu();
         }
 
+        if (ui::BeginMenu("Edit", !activeTab_.Expired()))
+        {
+            if (ui::MenuItem("Undo", "Ctrl+Z"))
+                activeTab_->Undo();
+            if (ui::MenuItem("Redo", "Ctrl+Y"))
+                activeTab_->Redo();
+
+            ui::Separator();
+
+            if (ui::MenuItem("Copy", "Ctrl+C"))
+                activeTab_->CopySelection();
+            if (ui::MenuItem("Paste", "Ctrl+V", false, !GetSubsystem<NodeClipboard>()->IsEmpty()))
+                activeTab_->PasteClipboard();
+            if (ui::MenuItem("Duplicate", "Ctrl+D"))
+                activeTab_->DuplicateSelection();
+            if (ui::BeginMenu("Duplicate Multiple"))
+            {
+                ui::InputInt("Copies", &duplicateCount_);
+                duplicateCount_ = Max(duplicateCount_, 1);
+                if (ui::MenuItem("Duplicate"))
+                    activeTab_->DuplicateSelection((unsigned)duplicateCount_);
+                ui::EndMenu();
+            }
+
+            ui::Separator();
+
+            if (ui::MenuItem("Create Prefab", nullptr, false, !activeTab_->GetSelection().Empty()))
+            {
+                const char* patterns[] = {"*.xml"};
+                if (const char* fileName = tinyfd_saveFileDialog("Create Prefab", ".", 1, patterns, "Prefab Files"))
+                    activeTab_->CreatePrefab(fileName);
+            }
+            if (ui::MenuItem("Apply To Prefab", nullptr, false, activeTab_->GetSelectedPrefab() != nullptr))
+                activeTab_->ApplyPrefab();
+
+            ui::EndMenu();
+        }
+
+        if (ui::BeginMenu("View"))
+        {
+            ui::MenuItem("Resource Browser", nullptr, &resourceBrowserWindowOpen_);
+            ui::MenuItem("Statistics", nullptr, &statisticsWindowOpen_);
+            ui::EndMenu();
+        }
+
         if (!activeTab_.Expired())
         {
             save |= ui::ToolbarButton(ICON_FA_FLOPPY_O);
@@ -280,6 +536,21 @@ void Editor::RenderMenuBar()
             ui::TextUnformatted("|");
             ui::SameLine(0, 3.f);
             activeTab_->RenderGizmoButtons();
+            ui::TextUnformatted("|");
+            ui::SameLine(0, 3.f);
+
+            bool playing = activeTab_->IsPlaying();
+            if (ui::ToolbarButton(playing ? ICON_FA_STOP : ICON_FA_PLAY))
+            {
+                if (playing)
+                    activeTab_->StopPlaying();
+                else
+                    activeTab_->StartPlaying();
+            }
+            ui::SameLine(0, 3.f);
+            if (ui::IsItemHovered())
+                ui::SetTooltip("%s", playing ? "Stop" : "Play");
+
             SendEvent(E_EDITORTOOLBARBUTTONS);
         }
 
@@ -290,37 +561,32 @@ void Editor::RenderMenuBar()
     {
         if (projectFilePath_.Empty())
         {
-            const char* patterns[] = {"*.xml"};
-            projectFilePath_ = tinyfd_saveFileDialog("Save Project As", ".", 1, patterns, "XML Files");
+            const char* patterns[] = {"*.project", "*.xml"};
+            projectFilePath_ = tinyfd_saveFileDialog("Save Project As", ".", 2, patterns, "Project Files");
         }
         SaveProject(projectFilePath_);
         for (auto& sceneTab: sceneTabs_)
-            sceneTab->SaveScene();
+        {
+            if (sceneTab->SaveScene())
+                autosave_->Discard(sceneTab);
+        }
     }
 }
 
 SceneTab* Editor::CreateNewScene(XMLElement project)
 {
-    SharedPtr<SceneTab> sceneTab;
     StringHash id;
 
     if (project.IsNull())
         id = idPool_.NewID();           // Make new ID only if scene is not being loaded from a project.
 
-    if (sceneTabs_.Empty())
-        sceneTab = new SceneTab(context_, id, "Hierarchy", ui::Slot_Right);
-    else
-        sceneTab = new SceneTab(context_, id, sceneTabs_.Back()->GetUniqueTitle(), ui::Slot_Tab);
+    SharedPtr<SceneTab> sceneTab = ConstructSceneTab(id);
 
     if (project.NotNull())
     {
         sceneTab->LoadProject(project);
-        if (!idPool_.TakeID(sceneTab->GetID()))
-        {
-            URHO3D_LOGERRORF("Scene loading failed because unique id %s is already taken",
-                sceneTab->GetID().ToString().CString());
+        if (!TakeSceneTabID(sceneTab))
             return nullptr;
-        }
     }
 
     // In order to render scene to a texture we must add a dummy node to scene rendered to a screen, which has material
@@ -329,6 +595,36 @@ SceneTab* Editor::CreateNewScene(XMLElement project)
     return sceneTab;
 }
 
+SceneTab* Editor::CreateNewScene(Deserializer& project)
+{
+    SharedPtr<SceneTab> sceneTab = ConstructSceneTab(StringHash());
+    sceneTab->LoadProject(project);
+    if (!TakeSceneTabID(sceneTab))
+        return nullptr;
+
+    sceneTabs_.Push(sceneTab);
+    return sceneTab;
+}
+
+SharedPtr<SceneTab> Editor::ConstructSceneTab(StringHash id)
+{
+    if (sceneTabs_.Empty())
+        return SharedPtr<SceneTab>(new SceneTab(context_, id, "Hierarchy", ui::Slot_Right));
+    else
+        return SharedPtr<SceneTab>(new SceneTab(context_, id, sceneTabs_.Back()->GetUniqueTitle(), ui::Slot_Tab));
+}
+
+bool Editor::TakeSceneTabID(SceneTab* sceneTab)
+{
+    if (!idPool_.TakeID(sceneTab->GetID()))
+    {
+        URHO3D_LOGERRORF("Scene loading failed because unique id %s is already taken",
+            sceneTab->GetID().ToString().CString());
+        return false;
+    }
+    return true;
+}
+
 bool Editor::IsActive(Scene* scene)
 {
     if (scene == nullptr || activeTab_.Null())
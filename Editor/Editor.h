@@ -25,6 +25,8 @@
 
 #include <Urho3D/Urho3DAll.h>
 #include <Toolbox/SystemUI/AttributeInspector.h>
+#include "Autosave.h"
+#include "BatchProcessor.h"
 #include "IDPool.h"
 
 using namespace std::placeholders;
@@ -55,10 +57,17 @@ public:
     void OnUpdate(VariantMap& args);
     /// Renders menu bar at the top of the screen.
     void RenderMenuBar();
+    /// Start deferred scene loads and distribute loading time between scenes that are loading.
+    void UpdateSceneLoading();
+    /// Renders modal popup offering to recover scenes autosaved by previous session.
+    void RenderRecoveryPopup();
     /// Create sample scene. Specify xml or json file with serialized scene contents to load them.
     /// \param project is xml element containing serialized scene information. This is same parameter that would be
     /// passed to SceneTab::LoadProject(scene).
     SceneTab* CreateNewScene(XMLElement project=XMLElement());
+    /// Create scene tab from binary project data. This is same data that would be passed to
+    /// SceneTab::LoadProject(source).
+    SceneTab* CreateNewScene(Deserializer& project);
     /// Return true if specified scene tab is focused and mouse hovers it.
     bool IsActive(Scene* scene);
     /// Return active scene tab.
@@ -67,6 +76,19 @@ public:
     const Vector<SharedPtr<SceneTab>>& GetSceneViews() const { return sceneTabs_; }
 
 protected:
+    /// Save editor configuration to xml.
+    void SaveProject(XMLElement root);
+    /// Save editor configuration to binary project file.
+    void SaveProject(Serializer& dest);
+    /// Load editor configuration from xml.
+    void LoadProject(XMLElement root);
+    /// Load editor configuration from binary project file. File id must already be read.
+    void LoadProject(Deserializer& source);
+    /// Create scene tab docked next to the last open scene tab.
+    SharedPtr<SceneTab> ConstructSceneTab(StringHash id);
+    /// Reserve unique id of loaded scene tab. Returns false and logs an error if id is already taken.
+    bool TakeSceneTabID(SceneTab* sceneTab);
+
     /// Pool tracking availability of unique IDs used by editor.
     IDPool idPool_;
     /// List of active scene tabs.
@@ -77,6 +99,16 @@ protected:
     String projectFilePath_;
     /// Flag which opens resource browser window.
     bool resourceBrowserWindowOpen_ = true;
+    /// Flag which opens scene statistics window.
+    bool statisticsWindowOpen_ = false;
+    /// Number of copies created by Edit > Duplicate Multiple.
+    int duplicateCount_ = 10;
+    /// Periodically saves modified scenes to recovery files.
+    SharedPtr<Autosave> autosave_;
+    /// Recovery files left by previous session which were not recovered or discarded yet.
+    StringVector recoveryFiles_;
+    /// Processes scenes passed on the command line when editor runs in batch mode.
+    SharedPtr<BatchProcessor> batch_;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,215 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include "EffectCatalog.h"
+
+
+namespace Urho3D
+{
+
+/// Resource directory containing renderpaths.
+static const char* renderPathsDir = "RenderPaths/";
+/// Resource directory containing postprocess effects.
+static const char* postProcessDir = "PostProcess/";
+/// Renderpath selected when project does not specify one. Changing default renderpath in engine will require
+/// patching editor.
+static const char* defaultRenderPathName = "Forward.xml";
+
+EffectCatalog::EffectCatalog(Context* context)
+    : Object(context)
+{
+    SubscribeToEvent(E_FILECHANGED, std::bind(&EffectCatalog::OnFileChanged, this, std::placeholders::_2));
+}
+
+void EffectCatalog::Update()
+{
+    if (!dirty_)
+        return;
+
+    ScanRenderPaths();
+    ScanEffects();
+    dirty_ = false;
+    version_++;
+}
+
+int EffectCatalog::GetRenderPathIndex(const String& fileName) const
+{
+    auto it = renderPaths_.Find(fileName);
+    if (it == renderPaths_.End())
+        return -1;
+    return static_cast<int>(it - renderPaths_.Begin());
+}
+
+const EffectCatalog::PostProcess* EffectCatalog::GetEffect(const String& effectPath) const
+{
+    auto it = effects_.Find(effectPath);
+    if (it == effects_.End())
+        return nullptr;
+    return &it->second_;
+}
+
+RenderPath* EffectCatalog::GetCachedRenderPath(const String& resourcePath)
+{
+    auto it = renderPathCache_.Find(resourcePath);
+    if (it != renderPathCache_.End())
+        return it->second_;
+
+    auto* file = GetSubsystem<ResourceCache>()->GetResource<XMLFile>(resourcePath);
+    if (file == nullptr)
+        return nullptr;
+
+    SharedPtr<RenderPath> renderPath(new RenderPath());
+    if (!renderPath->Load(file))
+        return nullptr;
+
+    renderPathCache_[resourcePath] = renderPath;
+    return renderPath;
+}
+
+SharedPtr<RenderPath> EffectCatalog::CreateRenderPath(const String& resourcePath)
+{
+    if (RenderPath* renderPath = GetCachedRenderPath(resourcePath))
+        return renderPath->Clone();
+    return SharedPtr<RenderPath>();
+}
+
+void EffectCatalog::ScanRenderPaths()
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+    auto* fileSystem = GetSubsystem<FileSystem>();
+
+    renderPaths_.Clear();
+    renderPathsEnumNames_.Clear();
+    for (const auto& dir: cache->GetResourceDirs())
+    {
+        Vector<String> renderPaths;
+        String scanDir = AddTrailingSlash(dir) + renderPathsDir;
+        fileSystem->ScanDir(renderPaths, scanDir, "*.xml", SCAN_FILES, false);
+        for (const auto& pathName: renderPaths)
+        {
+            // Same renderpath may exist in multiple resource dirs, cache returns first one.
+            if (!renderPaths_.Contains(pathName))
+                renderPaths_.Push(pathName);
+        }
+    }
+    Sort(renderPaths_.Begin(), renderPaths_.End());
+
+    for (const auto& pathName: renderPaths_)
+        renderPathsEnumNames_.Push(pathName.CString());
+    renderPathsEnumNames_.Push(nullptr);
+
+    defaultRenderPath_ = GetRenderPathIndex(defaultRenderPathName);
+    if (defaultRenderPath_ < 0)
+    {
+        URHO3D_LOGERRORF("Default RenderPath %s was not found.", defaultRenderPathName);
+        defaultRenderPath_ = 0;
+    }
+}
+
+void EffectCatalog::ScanEffects()
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+    auto* fileSystem = GetSubsystem<FileSystem>();
+
+    effects_.Clear();
+    for (const auto& dir: cache->GetResourceDirs())
+    {
+        Vector<String> effects;
+        String scanDir = AddTrailingSlash(dir) + postProcessDir;
+        fileSystem->ScanDir(effects, scanDir, "*.xml", SCAN_FILES, false);
+
+        for (const auto& effectFileName: effects)
+        {
+            String effectPath = postProcessDir + effectFileName;
+            XMLFile* effect = cache->GetResource<XMLFile>(effectPath);
+            if (effect == nullptr)
+                continue;
+
+            auto root = effect->GetRoot();
+            String tag;
+            for (auto command = root.GetChild("command"); command.NotNull(); command = command.GetNext("command"))
+            {
+                tag = command.GetAttribute("tag");
+
+                if (tag.Empty())
+                {
+                    URHO3D_LOGWARNING("Invalid PostProcess effect with empty tag");
+                    continue;
+                }
+
+                PostProcess* postprocess = &effects_[effectPath];
+                if (!postprocess->tags_.Contains(tag))
+                    postprocess->tags_.Push(tag);
+
+                for (auto parameter = command.GetChild("parameter"); parameter.NotNull();
+                    parameter = parameter.GetNext("parameter"))
+                {
+                    String name = parameter.GetAttribute("name");
+                    String valueString = parameter.GetAttribute("value");
+
+                    if (name.Empty() || valueString.Empty())
+                    {
+                        URHO3D_LOGWARNINGF("Invalid PostProcess effect tagged as %s", tag.CString());
+                        continue;
+                    }
+
+                    if (!postprocess->variables_.Contains(name))
+                        postprocess->variables_[name] = valueString.Split(' ').Size();
+                }
+            }
+        }
+    }
+
+    // Enum names point to tag strings, therefore they are built only after all tags are collected.
+    for (auto it = effects_.Begin(); it != effects_.End(); it++)
+    {
+        PostProcess& postprocess = it->second_;
+        Sort(postprocess.tags_.Begin(), postprocess.tags_.End());
+        if (postprocess.tags_.Size() > 1)
+        {
+            postprocess.tagEnumNames_.Push("None");
+            for (const auto& tag: postprocess.tags_)
+                postprocess.tagEnumNames_.Push(tag.CString());
+            postprocess.tagEnumNames_.Push(nullptr);
+        }
+    }
+}
+
+void EffectCatalog::OnFileChanged(VariantMap& args)
+{
+    using namespace FileChanged;
+    const String& resourceName = args[P_RESOURCENAME].GetString();
+    if (resourceName.StartsWith(renderPathsDir) || resourceName.StartsWith(postProcessDir))
+    {
+        renderPathCache_.Erase(resourceName);
+        dirty_ = true;
+    }
+}
+
+}
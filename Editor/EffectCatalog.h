@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Graphics/RenderPath.h>
+
+
+namespace Urho3D
+{
+
+/// Description of renderpaths and postprocess effects available in resource directories. Catalog is shared by all
+/// scene tabs, it is scanned once and rescanned only when files in RenderPaths/ or PostProcess/ change.
+class EffectCatalog : public Object
+{
+    URHO3D_OBJECT(EffectCatalog, Object);
+public:
+    struct PostProcess
+    {
+        /// List of postprocess tags present in the file.
+        StringVector tags_;
+        /// Fake enum name array for attribute when there are more than one tag.
+        PODVector<const char*> tagEnumNames_;
+        /// Variable names mapped to number of floats variable contains.
+        HashMap<String, int> variables_;
+    };
+
+    /// Construct.
+    explicit EffectCatalog(Context* context);
+    /// Rescan resource directories if catalog was invalidated.
+    void Update();
+    /// Return version of catalog. It changes every time catalog is rescanned.
+    unsigned GetVersion() const { return version_; }
+    /// Return sorted list of renderpath file names.
+    const StringVector& GetRenderPaths() const { return renderPaths_; }
+    /// Return fake enum name array of renderpaths.
+    const PODVector<const char*>& GetRenderPathEnumNames() const { return renderPathsEnumNames_; }
+    /// Return index of default renderpath.
+    int GetDefaultRenderPath() const { return defaultRenderPath_; }
+    /// Return index of renderpath with specified file name or -1.
+    int GetRenderPathIndex(const String& fileName) const;
+    /// Return postprocess effects mapped by their resource path.
+    const HashMap<String, PostProcess>& GetEffects() const { return effects_; }
+    /// Return postprocess effect stored in specified resource path or null.
+    const PostProcess* GetEffect(const String& effectPath) const;
+    /// Return renderpath loaded from specified resource path or null. File is parsed only once, returned object is
+    /// shared and must not be modified.
+    RenderPath* GetCachedRenderPath(const String& resourcePath);
+    /// Return a new copy of renderpath loaded from specified resource path or null.
+    SharedPtr<RenderPath> CreateRenderPath(const String& resourcePath);
+
+protected:
+    /// Rescan renderpaths.
+    void ScanRenderPaths();
+    /// Rescan postprocess effects.
+    void ScanEffects();
+    /// Invalidate catalog when renderpath or postprocess file changes.
+    void OnFileChanged(VariantMap& args);
+
+    /// Flag which signals that catalog should be rescanned.
+    bool dirty_ = true;
+    /// Version of catalog.
+    unsigned version_ = 0;
+    /// Cached effect data so we do not read disk on every frame.
+    HashMap<String, PostProcess> effects_;
+    /// Cached list of renderpaths.
+    StringVector renderPaths_;
+    /// Fake enum name array of renderpaths.
+    PODVector<const char*> renderPathsEnumNames_;
+    /// Index of default renderpath.
+    int defaultRenderPath_ = 0;
+    /// Parsed renderpaths and postprocess effects mapped by their resource path.
+    HashMap<String, SharedPtr<RenderPath>> renderPathCache_;
+};
+
+}
@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //
 
+#include "EffectCatalog.h"
 #include "SceneSettings.h"
 #include "SceneTab.h"
 #include "EditorEvents.h"
@@ -37,18 +38,56 @@ void SceneSettings::SaveProject(XMLElement scene)
 {
     auto settings = scene.CreateChild("settings");
     settings.CreateChild("saveElapsedTime").SetVariant(saveElapsedTime_);
+    settings.CreateChild("unfocusedFps").SetVariant(unfocusedFps_);
+    settings.CreateChild("adaptiveResolution").SetVariant(adaptiveResolution_);
+    settings.CreateChild("minRenderScale").SetVariant(minRenderScale_);
+    settings.CreateChild("idleFrames").SetVariant(idleFrames_);
 }
 
 void SceneSettings::LoadProject(XMLElement scene)
 {
-    if (auto saveElapsedTime = scene.GetChild("saveElapsedTime"))
+    auto settings = scene.GetChild("settings");
+    if (auto saveElapsedTime = settings.GetChild("saveElapsedTime"))
         saveElapsedTime_ = saveElapsedTime.GetVariant().GetBool();
+    if (auto unfocusedFps = settings.GetChild("unfocusedFps"))
+        unfocusedFps_ = unfocusedFps.GetVariant().GetInt();
+    if (auto adaptiveResolution = settings.GetChild("adaptiveResolution"))
+        adaptiveResolution_ = adaptiveResolution.GetVariant().GetBool();
+    if (auto minRenderScale = settings.GetChild("minRenderScale"))
+        minRenderScale_ = minRenderScale.GetVariant().GetFloat();
+    if (auto idleFrames = settings.GetChild("idleFrames"))
+        idleFrames_ = idleFrames.GetVariant().GetInt();
+}
+
+void SceneSettings::SaveProject(Serializer& dest)
+{
+    // Settings are stored by name so that adding new settings does not break older projects.
+    const auto& attributes = *GetAttributes();
+    dest.WriteVLE(attributes.Size());
+    for (unsigned i = 0; i < attributes.Size(); i++)
+    {
+        dest.WriteString(attributes[i].name_);
+        dest.WriteVariant(GetAttribute(i));
+    }
+}
+
+void SceneSettings::LoadProject(Deserializer& source)
+{
+    for (unsigned i = 0, count = source.ReadVLE(); i < count && !source.IsEof(); i++)
+    {
+        String name = source.ReadString();
+        SetAttribute(name, source.ReadVariant());
+    }
 }
 
 void SceneSettings::RegisterObject(Context* context)
 {
     context->RegisterFactory<SceneSettings>();
     URHO3D_ATTRIBUTE("Save Elapsed Time", bool, saveElapsedTime_, false, AM_EDIT);
+    URHO3D_ATTRIBUTE("Unfocused FPS", int, unfocusedFps_, 10, AM_EDIT);
+    URHO3D_ATTRIBUTE("Adaptive Resolution", bool, adaptiveResolution_, true, AM_EDIT);
+    URHO3D_ATTRIBUTE("Min Render Scale", float, minRenderScale_, 0.5f, AM_EDIT);
+    URHO3D_ATTRIBUTE("Idle Frames", int, idleFrames_, 10, AM_EDIT);
 }
 
 SceneEffects::SceneEffects(SceneTab* tab)
@@ -60,164 +99,97 @@ SceneEffects::SceneEffects(SceneTab* tab)
 
 void SceneEffects::Prepare(bool force)
 {
-    if (!force && !rebuild_)
-        return;
+    auto* catalog = GetSubsystem<EffectCatalog>();
+    catalog->Update();
 
+    if (force || catalogVersion_ != catalog->GetVersion())
+    {
+        RegisterEffectAttributes();
+        catalogVersion_ = catalog->GetVersion();
+        rebuild_ = true;
+    }
+
+    if (rebuild_)
+    {
+        UpdateVisibleAttributes();
+        rebuild_ = false;
+    }
+}
+
+void SceneEffects::RegisterEffectAttributes()
+{
     // A "fake" context value which allows us to use Urho3D attribute definition macros while storing attributes
     // locally.
     auto context = this;
-    attributes_.Clear();
+    auto* catalog = GetSubsystem<EffectCatalog>();
+    allAttributes_.Clear();
+    attributeEffects_.Clear();
+    registeringEffect_.Clear();
 
     // Update RenderPaths
     {
-        renderPaths_.Clear();
-        renderPathsEnumNames_.Clear();
-        auto defaultRenderPathIndex = -1;
-        for (const auto& dir: GetCache()->GetResourceDirs())
-        {
-            Vector<String> renderPaths;
-            String resourcePath = "RenderPaths/";
-            String scanDir = AddTrailingSlash(dir) + resourcePath;
-            GetFileSystem()->ScanDir(renderPaths, scanDir, "*.xml", SCAN_FILES, false);
-            renderPaths_.Push(renderPaths);
-        }
-
-        Sort(renderPaths_.Begin(), renderPaths_.End());
-        auto index = 0;
-        const String defaultRenderPath = "Forward.xml";
-        for (const auto& pathName: renderPaths_)
-        {
-            // Select default renderpath. Engine does not store renderpath name so we have to cache selected renderpath
-            // index here. In case index is not set - select default renderpath which is Forward.xml. Changing default
-            // renderpath in engine will require patching editor.
-            if (pathName == defaultRenderPath)
-            {
-                if (currentRenderPath_ < 0)
-                    currentRenderPath_ = index;
-                defaultRenderPathIndex = index;
-            }
-            renderPathsEnumNames_.Push(pathName.CString());
-            index++;
-        }
-        renderPathsEnumNames_.Push(nullptr);
-        if (defaultRenderPathIndex < 0)
-        {
-            URHO3D_LOGERRORF("Default RenderPath %s was not found.", defaultRenderPath.CString());
-            defaultRenderPathIndex = 0;
-        }
+        // Engine does not store renderpath name so we have to cache selected renderpath name here. In case it is not
+        // set - select default renderpath.
+        if (currentRenderPath_.Empty() && !catalog->GetRenderPaths().Empty())
+            currentRenderPath_ = catalog->GetRenderPaths()[catalog->GetDefaultRenderPath()];
 
         auto getter = [this](const SceneEffects*) -> int {
-            return currentRenderPath_;
+            return GetSubsystem<EffectCatalog>()->GetRenderPathIndex(currentRenderPath_);
         };
         auto setter = [this](SceneEffects*, int value) {
+            const StringVector& renderPaths = GetSubsystem<EffectCatalog>()->GetRenderPaths();
+            if (value < 0 || value >= renderPaths.Size())
+                return;
+
             // Without this check cache rebuild would re-set renderpath, and that resets all filter settings.
-            if (value != currentRenderPath_)
+            if (renderPaths[value] != currentRenderPath_)
             {
-                currentRenderPath_ = value;
-
-                // Warning: this is a hack. If we set renderpath here directly then it would reset selected postprocess
-                // effects. Instead we change current renderpath index and serialize scene state. Since index is already
-                // changed new renderpath will be written to xml. Then we load the save, which sets new renderpath to a
-                // viewport and restores postprocess effects. If this class expands you may have to split SaveProject()
-                // and LoadProject() and use only relevant subset of those routines here.
-                XMLFile file(context_);
-                XMLElement root = file.CreateRoot("scene");
-                SaveProject(root);
-                LoadProject(root);
-
-                rebuild_ = true;
+                // Setting new renderpath resets postprocess effects, therefore they are reapplied to the new one.
+                auto effects = GetEffectState();
+                LoadRenderPath("RenderPaths/" + renderPaths[value]);
+                ApplyEffectState(effects);
+                OnEffectsLoaded();
             }
         };
-        URHO3D_ENUM_ACCESSOR_ATTRIBUTE_FREE("RenderPath", getter, setter, int, &renderPathsEnumNames_.Front(),
-            defaultRenderPathIndex, AM_EDIT);
-        SetAttribute("RenderPath", currentRenderPath_);
-    }
-
-    effects_.Clear();
-    for (const auto& dir: GetCache()->GetResourceDirs())
-    {
-        Vector<String> effects;
-        String resourcePath = "PostProcess/";
-        String scanDir = AddTrailingSlash(dir) + resourcePath;
-        GetFileSystem()->ScanDir(effects, scanDir, "*.xml", SCAN_FILES, false);
-
-        for (const auto& effectFileName: effects)
-        {
-            auto effectPath = resourcePath + effectFileName;
-            XMLFile* effect = GetCache()->GetResource<XMLFile>(effectPath);
-
-            auto root = effect->GetRoot();
-            String tag;
-            for (auto command = root.GetChild("command"); command.NotNull(); command = command.GetNext("command"))
-            {
-                tag = command.GetAttribute("tag");
-
-                if (tag.Empty())
-                {
-                    URHO3D_LOGWARNING("Invalid PostProcess effect with empty tag");
-                    continue;
-                }
-
-                bool isNew = effects_.Find(tag) == effects_.End();
-                PostProcess* postprocess = &effects_[effectPath];
-                if (!postprocess->tags_.Contains(tag))
-                    postprocess->tags_.Push(tag);
-
-                for (auto parameter = command.GetChild("parameter"); parameter.NotNull();
-                    parameter = parameter.GetNext("parameter"))
-                {
-                    String name = parameter.GetAttribute("name");
-                    String valueString = parameter.GetAttribute("value");
-
-                    if (name.Empty() || valueString.Empty())
-                    {
-                        URHO3D_LOGWARNINGF("Invalid PostProcess effect tagged as %s", tag.CString());
-                        continue;
-                    }
-
-                    if (!postprocess->variables_.Contains(name))
-                        postprocess->variables_[name] = valueString.Split(' ').Size();
-                }
-            }
-        }
+        // Enum names are owned by catalog, attributes are re-registered whenever it changes.
+        auto enumNames = const_cast<const char**>(&catalog->GetRenderPathEnumNames().Front());
+        URHO3D_ENUM_ACCESSOR_ATTRIBUTE_FREE("RenderPath", getter, setter, int, enumNames,
+            catalog->GetDefaultRenderPath(), AM_EDIT);
     }
 
     // Register postprocess effect attributes
-    for (auto it = effects_.Begin(); it != effects_.End(); it++)
+    const auto& effects = catalog->GetEffects();
+    for (auto it = effects.Begin(); it != effects.End(); it++)
     {
-        Sort(it->second_.tags_.Begin(), it->second_.tags_.End());
-
         String fullPath = it->first_;
         String title = GetFileName(fullPath);
+        const StringVector& tags = it->second_.tags_;
 
-        bool effectEnabled = false;
-        if (it->second_.tags_.Size() == 1)
+        if (tags.Size() == 1)
         {
-            String tag = it->second_.tags_.Front();
+            String tag = tags.Front();
             auto getter = [this, tag](const SceneEffects*) -> bool {
                 auto path = tab_->GetViewport()->GetRenderPath();
                 return path->IsEnabled(tag);
             };
             auto setter = [this, tag, fullPath](SceneEffects*, bool enabled) {
                 auto path = tab_->GetViewport()->GetRenderPath();
-                if (!path->IsAdded(tag))
-                    path->Append(GetCache()->GetResource<XMLFile>(fullPath));
-                path->SetEnabled(tag, enabled);
+                if (enabled)
+                    EnablePostProcess(fullPath, tag);
+                else
+                    path->SetEnabled(tag, false);
                 rebuild_ = true;
                 using namespace EditorSceneEffectsChanged;
                 SendEvent(E_EDITORSCENEEFFECTSCHANGED, P_SCENETAB, tab_.Get());
             };
-            effectEnabled = tab_->GetViewport()->GetRenderPath()->IsEnabled(tag);
             URHO3D_MIXED_ACCESSOR_ATTRIBUTE_FREE(title.CString(), getter, setter, bool, false, AM_EDIT);
-            SetAttribute(title, effectEnabled);
         }
-        else if (it->second_.tags_.Size() > 1)
+        else if (tags.Size() > 1)
         {
-            auto getter = [this, fullPath](const SceneEffects*) -> int {
+            auto getter = [this, tags](const SceneEffects*) -> int {
                 auto path = tab_->GetViewport()->GetRenderPath();
-                const StringVector& allTags = effects_[fullPath].tags_;
                 auto index = 0;
-                for (const auto& tag: allTags)
+                for (const auto& tag: tags)
                 {
                     index++;
                     if (path->IsEnabled(tag))
@@ -225,20 +197,13 @@ void SceneEffects::Prepare(bool force)
                 }
                 return 0;
             };
-            auto setter = [this, fullPath](SceneEffects*, int value) {
+            auto setter = [this, tags, fullPath](SceneEffects*, int value) {
                 auto path = tab_->GetViewport()->GetRenderPath();
-                const StringVector& allTags = effects_[fullPath].tags_;
-
-                for (const auto& tag: allTags)
+                for (const auto& tag: tags)
                     path->SetEnabled(tag, false);
 
                 if (value > 0)
-                {
-                    String tag = allTags[value - 1];    // Dropdown has extra argument at the start
-                    if (!path->IsAdded(tag))
-                        path->Append(GetCache()->GetResource<XMLFile>(fullPath));
-                    path->SetEnabled(tag, true);
-                }
+                    EnablePostProcess(fullPath, tags[value - 1]);    // Dropdown has extra argument at the start
                 rebuild_ = true;
                 using namespace EditorSceneEffectsChanged;
                 SendEvent(E_EDITORSCENEEFFECTSCHANGED, P_SCENETAB, tab_.Get());
@@ -247,31 +212,13 @@ void SceneEffects::Prepare(bool force)
             // When one effect has multiple tags we assume that only one of those tags is supposed to be active during
             // runtime. In this case a dummy enum array is constructed and enum attribute is registered. It results in
             // a drop-down list for selecting a tag.
-            it->second_.tagEnumNames_.Push("None");
-            for (const auto& tagVal: it->second_.tags_)
-                it->second_.tagEnumNames_.Push(tagVal.CString());
-            it->second_.tagEnumNames_.Push(nullptr);
-
-            int index = 0;
-            for (const auto& tag: it->second_.tags_)
-            {
-                index++;
-                if (tab_->GetViewport()->GetRenderPath()->IsEnabled(tag))
-                {
-                    effectEnabled = true;
-                    break;
-                }
-            }
-            if (!effectEnabled)            // Select "None"
-                index = 0;
-            URHO3D_ENUM_ACCESSOR_ATTRIBUTE_FREE(title.CString(), getter, setter, int, &it->second_.tagEnumNames_.Front(), 0, AM_EDIT);
-            SetAttribute(title, index);
+            auto enumNames = const_cast<const char**>(&it->second_.tagEnumNames_.Front());
+            URHO3D_ENUM_ACCESSOR_ATTRIBUTE_FREE(title.CString(), getter, setter, int, enumNames, 0, AM_EDIT);
         }
 
-        // Do not show variables for disabled effects
-        if (!effectEnabled)
-            continue;
-
+        // Variables are registered for every effect, but shown only when effect is enabled. See
+        // UpdateVisibleAttributes().
+        registeringEffect_ = fullPath;
         StringVector variableKeys = it->second_.variables_.Keys();
         Sort(variableKeys.Begin(), variableKeys.End());
         for (const auto& name: variableKeys)
@@ -292,7 +239,6 @@ void SceneEffects::Prepare(bool force)
                     SendEvent(E_EDITORSCENEEFFECTSCHANGED, P_SCENETAB, tab_.Get());
                 };
                 URHO3D_MIXED_ACCESSOR_ATTRIBUTE_FREE(name.CString(), getter, setter, float, 0.f, AM_EDIT);
-                SetAttribute(name, tab_->GetViewport()->GetRenderPath()->GetShaderParameter(name).GetFloat());
                 break;
             }
             case 2:
@@ -308,7 +254,6 @@ void SceneEffects::Prepare(bool force)
                     SendEvent(E_EDITORSCENEEFFECTSCHANGED, P_SCENETAB, tab_.Get());
                 };
                 URHO3D_MIXED_ACCESSOR_ATTRIBUTE_FREE(name.CString(), getter, setter, Vector2, Vector2::ZERO, AM_EDIT);
-                SetAttribute(name, tab_->GetViewport()->GetRenderPath()->GetShaderParameter(name).GetVector2());
                 break;
             }
             case 3:
@@ -324,7 +269,6 @@ void SceneEffects::Prepare(bool force)
                     SendEvent(E_EDITORSCENEEFFECTSCHANGED, P_SCENETAB, tab_.Get());
                 };
                 URHO3D_MIXED_ACCESSOR_ATTRIBUTE_FREE(name.CString(), getter, setter, Vector3, Vector3::ZERO, AM_EDIT);
-                SetAttribute(name, tab_->GetViewport()->GetRenderPath()->GetShaderParameter(name).GetVector3());
                 break;
             }
             case 4:
@@ -340,7 +284,6 @@ void SceneEffects::Prepare(bool force)
                     SendEvent(E_EDITORSCENEEFFECTSCHANGED, P_SCENETAB, tab_.Get());
                 };
                 URHO3D_MIXED_ACCESSOR_ATTRIBUTE_FREE(name.CString(), getter, setter, Vector4, Vector4::ZERO, AM_EDIT);
-                SetAttribute(name, tab_->GetViewport()->GetRenderPath()->GetShaderParameter(name).GetVector4());
                 break;
             }
             default:
@@ -348,84 +291,215 @@ void SceneEffects::Prepare(bool force)
                 break;
             }
         }
+        registeringEffect_.Clear();
     }
-    rebuild_ = false;
 }
 
-void SceneEffects::SaveProject(XMLElement scene)
+void SceneEffects::UpdateVisibleAttributes()
 {
-    scene.CreateChild("renderpath").SetAttribute("path", "RenderPaths/" + renderPaths_[currentRenderPath_]);
+    attributes_.Clear();
+    attributesVersion_++;
 
-    RenderPath* path = tab_->GetViewport()->GetRenderPath();
-    for (auto it = effects_.Begin(); it != effects_.End(); it++)
+    // Attributes of one effect are registered consecutively, so enabled state is queried once per effect.
+    String lastEffect;
+    bool lastEnabled = true;
+    for (unsigned i = 0; i < allAttributes_.Size(); i++)
     {
-        auto fullPath = it->first_;
-        for (const auto& tag: it->second_.tags_)
+        const String& effectPath = attributeEffects_[i];
+        if (!effectPath.Empty())
         {
-            if (!path->IsEnabled(tag))
-                continue;
-
-            auto postprocess = scene.CreateChild("postprocess");
-            postprocess.SetAttribute("tag", tag);
-            postprocess.SetAttribute("path", fullPath);
-
-            for (const auto& variable: it->second_.variables_)
+            if (effectPath != lastEffect)
             {
-                auto var = postprocess.CreateChild(variable.first_);
-                var.SetVariant(path->GetShaderParameter(variable.first_));
+                lastEffect = effectPath;
+                lastEnabled = IsPostProcessEnabled(effectPath);
             }
+            // Do not show variables for disabled effects
+            if (!lastEnabled)
+                continue;
         }
+        attributes_.Push(allAttributes_[i]);
     }
+}
 
+void SceneEffects::SaveProject(XMLElement scene)
+{
+    scene.CreateChild("renderpath").SetAttribute("path", "RenderPaths/" + currentRenderPath_);
+
+    for (const auto& state: GetEffectState())
+    {
+        auto postprocess = scene.CreateChild("postprocess");
+        postprocess.SetAttribute("tag", state.tag_);
+        postprocess.SetAttribute("path", state.path_);
+
+        for (const auto& variable: state.variables_)
+        {
+            auto var = postprocess.CreateChild(variable.first_);
+            var.SetVariant(variable.second_);
+        }
+    }
 }
 
 void SceneEffects::LoadProject(XMLElement scene)
 {
     if (auto renderpath = scene.GetChild("renderpath"))
+        LoadRenderPath(renderpath.GetAttribute("path"));
+
+    Vector<PostProcessState> effects;
+    for (auto postprocess = scene.GetChild("postprocess"); postprocess.NotNull();
+        postprocess = postprocess.GetNext("postprocess"))
     {
-        String path = renderpath.GetAttribute("path");
-        String fileName = GetFileNameAndExtension(path);
-        currentRenderPath_ = 0;
-        for (const auto& name: renderPaths_)
+        PostProcessState state;
+        state.tag_ = postprocess.GetAttribute("tag");
+        state.path_ = postprocess.GetAttribute("path");
+        for (auto child = postprocess.GetChild(); child.NotNull(); child = child.GetNext())
+            state.variables_[child.GetName()] = child.GetVariant();
+        effects.Push(state);
+    }
+    ApplyEffectState(effects);
+
+    OnEffectsLoaded();
+}
+
+void SceneEffects::SaveProject(Serializer& dest)
+{
+    dest.WriteString(currentRenderPath_.Empty() ? String::EMPTY : "RenderPaths/" + currentRenderPath_);
+
+    auto effects = GetEffectState();
+    dest.WriteVLE(effects.Size());
+    for (const auto& state: effects)
+    {
+        dest.WriteString(state.tag_);
+        dest.WriteString(state.path_);
+        dest.WriteVLE(state.variables_.Size());
+        for (const auto& variable: state.variables_)
         {
-            if (name == fileName)
-                break;
-            currentRenderPath_++;
+            dest.WriteString(variable.first_);
+            dest.WriteVariant(variable.second_);
         }
-        if (currentRenderPath_ >= renderPaths_.Size())
+    }
+}
+
+void SceneEffects::LoadProject(Deserializer& source)
+{
+    String renderPath = source.ReadString();
+    if (!renderPath.Empty())
+        LoadRenderPath(renderPath);
+
+    Vector<PostProcessState> effects;
+    for (unsigned i = 0, count = source.ReadVLE(); i < count && !source.IsEof(); i++)
+    {
+        PostProcessState state;
+        state.tag_ = source.ReadString();
+        state.path_ = source.ReadString();
+        for (unsigned j = 0, numVariables = source.ReadVLE(); j < numVariables; j++)
         {
-            currentRenderPath_ = -1;
-            URHO3D_LOGERRORF("RenderPath %s was not found.", path.CString());
+            String name = source.ReadString();
+            state.variables_[name] = source.ReadVariant();
         }
-        else
-            tab_->GetViewport()->SetRenderPath(GetCache()->GetResource<XMLFile>(path));
+        effects.Push(state);
+    }
+    ApplyEffectState(effects);
+
+    OnEffectsLoaded();
+}
+
+void SceneEffects::LoadRenderPath(const String& path)
+{
+    auto* catalog = GetSubsystem<EffectCatalog>();
+    String fileName = GetFileNameAndExtension(path);
+    SharedPtr<RenderPath> renderPath;
+    if (catalog->GetRenderPathIndex(fileName) >= 0)
+        renderPath = catalog->CreateRenderPath(path);
+
+    if (renderPath.Null())
+    {
+        currentRenderPath_.Clear();
+        URHO3D_LOGERRORF("RenderPath %s was not found.", path.CString());
+    }
+    else
+    {
+        currentRenderPath_ = fileName;
+        tab_->GetViewport()->SetRenderPath(renderPath);
     }
+}
 
+RenderPath* SceneEffects::EnablePostProcess(const String& effectPath, const String& tagName)
+{
     RenderPath* path = tab_->GetViewport()->GetRenderPath();
-    for (auto postprocess = scene.GetChild("postprocess"); postprocess.NotNull();
-        postprocess = postprocess.GetNext("postprocess"))
+    if (!path->IsAdded(tagName))
     {
-        auto effectPath = postprocess.GetAttribute("path");
-        auto tagName = postprocess.GetAttribute("tag");
+        auto* catalog = GetSubsystem<EffectCatalog>();
+        if (RenderPath* effectRenderPath = catalog->GetCachedRenderPath(effectPath))
+        {
+            // Same as RenderPath::Append(), but commands are copied from already parsed effect.
+            for (const auto& renderTarget: effectRenderPath->renderTargets_)
+                path->AddRenderTarget(renderTarget);
+            for (const auto& command: effectRenderPath->commands_)
+                path->AddCommand(command);
+        }
+        if (const auto* effect = catalog->GetEffect(effectPath))
+        {
+            // Some render paths have multiple tags and appending enables them all. Disable all tags
+            // in added path, later on only selected tag will be enabled.
+            for (const auto& tag: effect->tags_)
+                path->SetEnabled(tag, false);
+        }
+    }
 
-        if (!path->IsAdded(tagName))
+    path->SetEnabled(tagName, true);
+    return path;
+}
+
+Vector<SceneEffects::PostProcessState> SceneEffects::GetEffectState()
+{
+    Vector<PostProcessState> result;
+    RenderPath* path = tab_->GetViewport()->GetRenderPath();
+    const auto& effects = GetSubsystem<EffectCatalog>()->GetEffects();
+    for (auto it = effects.Begin(); it != effects.End(); it++)
+    {
+        for (const auto& tag: it->second_.tags_)
         {
-            path->Append(GetCache()->GetResource<XMLFile>(effectPath));
-            if (effects_.Contains(effectPath))
-            {
-                // Some render paths have multiple tags and appending enables them all. Disable all tags
-                // in added path, later on only selected tag will be enabled.
-                for (const auto& tag: effects_[effectPath].tags_)
-                    path->SetEnabled(tag, false);
-            }
+            if (!path->IsEnabled(tag))
+                continue;
+
+            PostProcessState state;
+            state.tag_ = tag;
+            state.path_ = it->first_;
+            for (const auto& variable: it->second_.variables_)
+                state.variables_[variable.first_] = path->GetShaderParameter(variable.first_);
+            result.Push(state);
         }
+    }
+    return result;
+}
 
-        path->SetEnabled(tagName, true);
+void SceneEffects::ApplyEffectState(const Vector<PostProcessState>& effects)
+{
+    for (const auto& state: effects)
+    {
+        RenderPath* path = EnablePostProcess(state.path_, state.tag_);
+        for (const auto& variable: state.variables_)
+            path->SetShaderParameter(variable.first_, variable.second_);
+    }
+}
 
-        for (auto child = postprocess.GetChild(); child.NotNull(); child = child.GetNext())
-            path->SetShaderParameter(child.GetName(), child.GetVariant());
+bool SceneEffects::IsPostProcessEnabled(const String& effectPath)
+{
+    const auto* effect = GetSubsystem<EffectCatalog>()->GetEffect(effectPath);
+    if (effect == nullptr)
+        return false;
+
+    RenderPath* path = tab_->GetViewport()->GetRenderPath();
+    for (const auto& tag: effect->tags_)
+    {
+        if (path->IsEnabled(tag))
+            return true;
     }
+    return false;
+}
 
+void SceneEffects::OnEffectsLoaded()
+{
     using namespace EditorSceneEffectsChanged;
     SendEvent(E_EDITORSCENEEFFECTSCHANGED, P_SCENETAB, tab_.Get());
 
@@ -440,7 +514,8 @@ const Vector<AttributeInfo>* SceneEffects::GetAttributes() const
 template<class T>
 AttributeHandle SceneEffects::RegisterAttribute(const AttributeInfo& attr)
 {
-    attributes_.Push(attr);
+    allAttributes_.Push(attr);
+    attributeEffects_.Push(registeringEffect_);
 }
 
 }
@@ -23,6 +23,8 @@
 #pragma once
 
 
+#include <Urho3D/IO/Deserializer.h>
+#include <Urho3D/IO/Serializer.h>
 #include <Urho3D/Scene/Serializable.h>
 #include <Urho3D/Resource/XMLElement.h>
 
@@ -30,6 +32,7 @@
 namespace Urho3D
 {
 
+class RenderPath;
 class SceneTab;
 
 /// Class handling common scene settings
@@ -43,11 +46,23 @@ public:
     void SaveProject(XMLElement scene);
     /// Load settings from a project file.
     void LoadProject(XMLElement scene);
+    /// Save settings into binary project file.
+    void SaveProject(Serializer& dest);
+    /// Load settings from a binary project file.
+    void LoadProject(Deserializer& source);
     /// Register object with engine.
     static void RegisterObject(Context* context);
 
     /// Flag which determines if "Elapsed Time" attribute of a scene should be saved.
     bool saveElapsedTime_ = false;
+    /// Rate at which scene view is rendered when it is visible, but not focused. 0 renders it on every frame.
+    int unfocusedFps_ = 10;
+    /// Flag which enables rendering scene at reduced resolution while camera or gizmo are moving.
+    bool adaptiveResolution_ = true;
+    /// Fraction of full resolution that scene is rendered at while navigating.
+    float minRenderScale_ = 0.5f;
+    /// Number of frames without movement after which full resolution is restored.
+    int idleFrames_ = 10;
 };
 
 /// Class handling scene postprocess effect settings
@@ -57,44 +72,73 @@ class SceneEffects : public Serializable
 public:
     /// Construct
     explicit SceneEffects(SceneTab* tab);
-    /// This method should be called before rendering attributes. It handles rebuilding of attribute cache.
+    /// This method should be called before rendering attributes. It handles rebuilding of attribute cache when effect
+    /// catalog changes and refreshes list of visible attributes when effects are toggled.
     void Prepare(bool force=false);
     /// Save settings into project file.
     void SaveProject(XMLElement scene);
     /// Load settings from a project file.
     void LoadProject(XMLElement scene);
+    /// Save settings into binary project file.
+    void SaveProject(Serializer& dest);
+    /// Load settings from a binary project file.
+    void LoadProject(Deserializer& source);
     /// Returns custom list of attributes that are different per instance.
     const Vector<AttributeInfo>* GetAttributes() const override;
+    /// Return version of attribute list. It changes every time list of visible attributes is rebuilt.
+    unsigned GetAttributesVersion() const { return attributesVersion_; }
 
 protected:
+    /// State of one enabled postprocess tag.
+    struct PostProcessState
+    {
+        /// Resource path of postprocess effect.
+        String path_;
+        /// Enabled tag.
+        String tag_;
+        /// Values of effect shader parameters.
+        HashMap<String, Variant> variables_;
+    };
+
     /// Method mimicking Context attribute registration, required for using engine attribute macros for registering
     /// custom per-object attributes.
     template <class T> AttributeHandle RegisterAttribute(const AttributeInfo& attr);
+    /// Register attributes of all renderpaths and postprocess effects found in effect catalog.
+    void RegisterEffectAttributes();
+    /// Rebuild list of visible attributes. Variables of disabled effects are hidden.
+    void UpdateVisibleAttributes();
+    /// Set renderpath loaded from specified resource path to the viewport of scene tab.
+    void LoadRenderPath(const String& path);
+    /// Append postprocess effect to viewport renderpath if it is not added yet and enable specified tag. Returns
+    /// renderpath of the viewport.
+    RenderPath* EnablePostProcess(const String& effectPath, const String& tagName);
+    /// Return state of all enabled postprocess tags.
+    Vector<PostProcessState> GetEffectState();
+    /// Enable postprocess tags and set their shader parameters.
+    void ApplyEffectState(const Vector<PostProcessState>& effects);
+    /// Return true if any tag of specified postprocess effect is enabled.
+    bool IsPostProcessEnabled(const String& effectPath);
+    /// Notify inspector about loaded effects and schedule attribute rebuild.
+    void OnEffectsLoaded();
 
-    /// Flag which signals that attributes should be rebuilt.
+    /// Flag which signals that list of visible attributes should be refreshed.
     bool rebuild_ = true;
     /// Pointer to tab which owns this object.
     WeakPtr<SceneTab> tab_;
-
-    struct PostProcess
-    {
-        /// List of postprocess tags present in the file.
-        StringVector tags_;
-        /// Fake enum name array for attribute when there are more than one tag.
-        PODVector<const char*> tagEnumNames_;
-        /// Variable names mapped to number of floats variable contains.
-        HashMap<String, int> variables_;
-    };
-    /// Cached effect data so we do not read disk on every frame.
-    HashMap<String, PostProcess> effects_;
-    /// Cached list of renderpaths.
-    StringVector renderPaths_;
-    /// Fake enum name array of renderpaths.
-    PODVector<const char*> renderPathsEnumNames_;
-    /// Index of current renderpath
-    int currentRenderPath_ = -1;
+    /// Version of effect catalog attributes were registered from.
+    unsigned catalogVersion_ = 0;
+    /// File name of current renderpath.
+    String currentRenderPath_;
+    /// All registered attributes.
+    Vector<AttributeInfo> allAttributes_;
+    /// Paths of effects that registered attributes belong to. Empty for attributes which are always visible.
+    StringVector attributeEffects_;
+    /// Path of effect whose variable attributes are being registered.
+    String registeringEffect_;
     /// List of attributes available at the moment.
     Vector<AttributeInfo> attributes_;
+    /// Incremented every time attributes_ is rebuilt.
+    unsigned attributesVersion_ = 0;
 };
 
 }
@@ -33,25 +33,55 @@
 namespace Urho3D
 {
 
+/// Distance in pixels mouse has to be dragged for click to become a marquee selection.
+static const int marqueeDragThreshold = 4;
+
+/// Read and parse json scene file. Runs on a worker thread.
+static void ParseSceneFile(const WorkItem* item, unsigned threadIndex)
+{
+    auto* json = reinterpret_cast<JSONFile*>(item->aux_);
+    SharedPtr<File> file = json->GetSubsystem<ResourceCache>()->GetFile(json->GetName(), false);
+    if (file.NotNull())
+        json->BeginLoad(*file);
+}
+
 SceneTab::SceneTab(Context* context, StringHash id, const String& afterDockName, ui::DockSlot_ position)
     : SceneView(context, {0, 0, 1024, 768})
     , gizmo_(context)
     , inspector_(context)
+    , undo_(context)
+    , searchIndex_(context)
+    , statistics_(context)
     , placeAfter_(afterDockName)
     , placePosition_(position)
     , id_(id)
 {
     SetTitle(title_);
 
+    searchIndex_.SetScene(scene_);
+    statistics_.SetScene(scene_);
     settings_ = new SceneSettings(context);
     effectSettings_ = new SceneEffects(this);
+    // Scene is rendered only when tab is visible, see UpdateViewSurface().
+    SetUpdateMode(SURFACE_MANUALUPDATE);
+    // Scene is updated only while playing, see StartPlaying().
+    scene_->SetUpdateEnabled(false);
 
     SubscribeToEvent(this, E_EDITORSELECTIONCHANGED, std::bind(&SceneTab::OnNodeSelectionChanged, this));
     SubscribeToEvent(effectSettings_, E_EDITORSCENEEFFECTSCHANGED, std::bind(&AttributeInspector::CopyEffectsFrom,
                                                                              &inspector_, viewport_));
+    SubscribeToEvent(&inspector_, E_ATTRIBUTEINSPECTVALUEMODIFIED,
+        std::bind(&SceneTab::OnInspectorValueModified, this, std::placeholders::_2));
+    for (StringHash eventType: {E_NODEADDED, E_NODEREMOVED, E_COMPONENTADDED, E_COMPONENTREMOVED, E_NODENAMECHANGED,
+                                E_NODEENABLEDCHANGED, E_COMPONENTENABLEDCHANGED})
+        SubscribeToEvent(scene_, eventType, std::bind(&SceneTab::OnSceneModified, this, std::placeholders::_2));
 }
 
-SceneTab::~SceneTab() = default;
+SceneTab::~SceneTab()
+{
+    // Worker thread may still be parsing scene file owned by this tab.
+    CancelLoading();
+}
 
 void SceneTab::SetSize(const IntRect& rect)
 {
@@ -67,6 +97,9 @@ bool SceneTab::RenderWindow()
     if (GetInput()->IsMouseVisible())
         lastMousePosition_ = GetInput()->GetMousePosition();
 
+    // Async loading progresses only in scene updates.
+    scene_->SetUpdateEnabled(IsPlaying() || scene_->IsAsyncLoading());
+
     ui::SetNextDockPos(placeAfter_.CString(), placePosition_, ImGuiCond_FirstUseEver);
     if (ui::BeginDock(uniqueTitle_.CString(), &open, windowFlags_))
     {
@@ -80,7 +113,7 @@ bool SceneTab::RenderWindow()
 
         ImGuizmo::SetDrawlist();
         ui::SetCursorPos(ui::GetCursorPos() - style.WindowPadding);
-        ui::Image(texture_, ToImGui(rect_.Size()));
+        ui::Image(texture_, ToImGui(rect_.Size()), {0, 0}, ToImGui(GetRenderedUV()));
 
         if (rect_.IsInside(lastMousePosition_) == INSIDE)
         {
@@ -95,9 +128,17 @@ bool SceneTab::RenderWindow()
         else
             isActive_ = false;
 
-        camera_->GetComponent<DebugCameraController>()->SetEnabled(isActive_);
+        auto cameraController = camera_->GetComponent<DebugCameraController>();
+        cameraController->SetEnabled(isActive_);
+        // Scene does not send update events while it is edited or loading asynchronously, keep camera responsive.
+        if (isActive_ && (!IsPlaying() || scene_->IsAsyncLoading()))
+            cameraController->Update(GetTime()->GetTimeStep());
+
+        if (gizmo_.ManipulateSelection(GetCamera()))
+            SetModified();
 
-        gizmo_.ManipulateSelection(GetCamera());
+        UpdateRenderScale();
+        UpdateViewSurface();
 
         // Update scene view rect according to window position
         // if (!GetInput()->GetMouseButtonDown(MOUSEB_LEFT))
@@ -119,40 +160,29 @@ bool SceneTab::RenderWindow()
             // Prevent dragging window when scene view is clicked.
             windowFlags_ = ImGuiWindowFlags_NoMove;
 
-            // Handle object selection.
+            // Selection starts on mouse press and is resolved on release as a click or a marquee selection.
             if (!gizmo_.IsActive() && GetInput()->GetMouseButtonPress(MOUSEB_LEFT))
             {
-                IntVector2 pos = GetInput()->GetMousePosition();
-                pos -= rect_.Min();
-
-                Ray cameraRay = GetCamera()->GetScreenRay((float)pos.x_ / rect_.Width(), (float)pos.y_ / rect_.Height());
-                // Pick only geometry objects, not eg. zones or lights, only get the first (closest) hit
-                PODVector<RayQueryResult> results;
-
-                RayOctreeQuery query(results, cameraRay, RAY_TRIANGLE, M_INFINITY, DRAWABLE_GEOMETRY);
-                scene_->GetComponent<Octree>()->RaycastSingle(query);
-
-                if (!results.Size())
-                {
-                    // When object geometry was not hit by a ray - query for object bounding box.
-                    RayOctreeQuery query2(results, cameraRay, RAY_OBB, M_INFINITY, DRAWABLE_GEOMETRY);
-                    scene_->GetComponent<Octree>()->RaycastSingle(query2);
-                }
-
-                if (results.Size())
-                {
-                    WeakPtr<Node> clickNode(results[0].drawable_->GetNode());
-                    if (!GetInput()->GetKeyDown(KEY_CTRL))
-                        UnselectAll();
-
-                    ToggleSelection(clickNode);
-                }
-                else
-                    UnselectAll();
+                selectionStart_ = GetInput()->GetMousePosition();
+                isSelecting_ = true;
             }
+
+            UpdateHoveredNode();
         }
         else
+        {
             windowFlags_ = 0;
+            hoveredNode_.Reset();
+        }
+
+        if (isSelecting_)
+            UpdateSelection();
+
+        if (isActive_ && !ui::IsAnyItemActive())
+            HandleEditShortcuts();
+
+        if (IsLoading())
+            RenderLoadingProgress();
 
         const auto tabContextMenuTitle = "SceneTab context menu";
         if (ui::IsDockTabHovered() && GetInput()->GetMouseButtonPress(MOUSEB_RIGHT))
@@ -185,35 +215,218 @@ void SceneTab::LoadScene(const String& filePath)
     if (filePath.Empty())
         return;
 
-    if (filePath.EndsWith(".xml", false))
+    // Parse item of previous json scene writes into a file owned by this tab.
+    CancelLoading();
+
+    if (filePath.EndsWith(".xml", false) || filePath.EndsWith(".bin", false))
     {
-        if (scene_->LoadXML(GetCache()->GetResource<XMLFile>(filePath)->GetRoot()))
+        // Only root components are loaded right away. Child nodes are loaded over next frames while resources are
+        // preloaded by background loader of resource cache.
+        SharedPtr<File> file = GetCache()->GetFile(filePath);
+        bool loading = file.NotNull() && ReplaceScene([&]() {
+            if (filePath.EndsWith(".bin", false))
+                return scene_->LoadAsync(file);
+            return scene_->LoadAsyncXML(file);
+        });
+
+        if (loading)
         {
-            path_ = filePath;
-            CreateObjects();
+            path_ = forgetScenePath_ ? String::EMPTY : filePath;
+            savedRevision_ = revision_;
         }
         else
             URHO3D_LOGERRORF("Loading scene %s failed", GetFileName(filePath).CString());
+        forgetScenePath_ = false;
     }
     else if (filePath.EndsWith(".json", false))
     {
-        if (scene_->LoadJSON(GetCache()->GetResource<JSONFile>(filePath)->GetRoot()))
+        // There is no async json scene loader. File is parsed on a worker thread and scene is instantiated by
+        // UpdateLoading() once parsing is done.
+        auto* workQueue = GetSubsystem<WorkQueue>();
+        parsedScene_ = new JSONFile(context_);
+        parsedScene_->SetName(filePath);
+        parseItem_ = workQueue->GetFreeItem();
+        parseItem_->workFunction_ = ParseSceneFile;
+        parseItem_->aux_ = parsedScene_.Get();
+        parseItem_->priority_ = 0;
+        parseItem_->sendEvent_ = false;
+
+        if (workQueue->GetNumThreads() > 0)
+            workQueue->AddWorkItem(parseItem_);
+        else
         {
-            path_ = filePath;
-            CreateObjects();
+            ParseSceneFile(parseItem_, 0);
+            parseItem_->completed_ = true;
+            UpdateLoading();
         }
-        else
-            URHO3D_LOGERRORF("Loading scene %s failed", GetFileName(filePath).CString());
     }
     else
         URHO3D_LOGERRORF("Unknown scene file format %s", GetExtension(filePath).CString());
 }
 
+void SceneTab::StartPendingLoad()
+{
+    String filePath = pendingScenePath_;
+    LoadScene(filePath);
+}
+
+void SceneTab::CancelLoading()
+{
+    pendingScenePath_.Clear();
+    if (parseItem_.Null())
+        return;
+
+    // Item that was already picked up by a worker thread can not be removed, wait for it instead.
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    if (!workQueue->RemoveWorkItem(parseItem_))
+    {
+        while (!parseItem_->completed_)
+        {
+            workQueue->Complete(parseItem_->priority_);
+            Time::Sleep(0);
+        }
+    }
+    parseItem_.Reset();
+    parsedScene_.Reset();
+}
+
+String SceneTab::GetLoadingScenePath() const
+{
+    if (IsLoadPending())
+        return pendingScenePath_;
+    if (parsedScene_.NotNull())
+        return parsedScene_->GetName();
+    return path_;
+}
+
+bool SceneTab::IsLoading() const
+{
+    return IsLoadPending() || parseItem_.NotNull() || scene_->IsAsyncLoading();
+}
+
+void SceneTab::UpdateLoading()
+{
+    if (parseItem_.Null() || !parseItem_->completed_)
+        return;
+
+    SharedPtr<JSONFile> json(parsedScene_);
+    parseItem_.Reset();
+    parsedScene_.Reset();
+
+    const JSONValue& root = json->GetRoot();
+    if (root.IsObject() && ReplaceScene([&]() { return scene_->LoadJSON(root); }))
+    {
+        path_ = forgetScenePath_ ? String::EMPTY : json->GetName();
+        savedRevision_ = revision_;
+    }
+    else
+        URHO3D_LOGERRORF("Loading scene %s failed", GetFileName(json->GetName()).CString());
+    forgetScenePath_ = false;
+}
+
+bool SceneTab::ReplaceScene(const std::function<bool()>& load)
+{
+    // Loading removes editor objects from the scene. They are recreated afterwards and camera view is preserved.
+    Vector3 position = camera_->GetPosition();
+    Quaternion rotation = camera_->GetRotation();
+    bool light = camera_->GetComponent<Light>()->IsEnabled();
+
+    // Loaded scene ends play session, there is nothing to restore. Undo history refers to nodes of previous scene.
+    playSnapshot_.Clear();
+    undo_.Clear();
+    // Scene which was waiting to be loaded or parsed would overwrite the new one once ready.
+    CancelLoading();
+    bool result = load();
+
+    if (camera_.Expired())
+    {
+        CreateObjects();
+        camera_->SetPosition(position);
+        camera_->SetRotation(rotation);
+        camera_->GetComponent<Light>()->SetEnabled(light);
+    }
+    return result;
+}
+
 bool SceneTab::SaveScene(const String& filePath)
 {
     auto resourcePath = filePath.Empty() ? path_ : filePath;
+    if (IsLoading())
+    {
+        URHO3D_LOGERRORF("Saving scene to %s failed, scene is still loading.", resourcePath.CString());
+        return false;
+    }
+    if (IsPlaying())
+    {
+        URHO3D_LOGERRORF("Saving scene to %s failed, scene is playing.", resourcePath.CString());
+        return false;
+    }
+
     auto fullPath = GetCache()->GetResourceFileName(resourcePath);
     File file(context_, fullPath, FILE_WRITE);
+    bool result = WriteScene(file, fullPath);
+
+    if (result)
+    {
+        if (!filePath.Empty())
+            path_ = filePath;
+        savedRevision_ = revision_;
+    }
+    else
+        URHO3D_LOGERRORF("Saving scene to %s failed.", resourcePath.CString());
+
+    return result;
+}
+
+bool SceneTab::SaveSceneSnapshot(Serializer& dest)
+{
+    if (IsLoading() || IsPlaying())
+        return false;
+    return WriteScene(dest, ".bin");
+}
+
+bool SceneTab::LoadSceneSnapshot(Deserializer& source, const String& scenePath)
+{
+    if (!ReplaceScene([&]() { return scene_->Load(source); }))
+    {
+        URHO3D_LOGERRORF("Loading scene snapshot of %s failed", scenePath.CString());
+        return false;
+    }
+
+    path_ = scenePath;
+    forgetScenePath_ = false;
+    // Snapshot differs from scene file on the disk.
+    SetModified();
+    return true;
+}
+
+bool SceneTab::StartPlaying()
+{
+    if (IsLoading() || IsPlaying())
+        return false;
+
+    playSnapshot_.Save(scene_);
+    playRevision_ = revision_;
+    scene_->SetUpdateEnabled(true);
+    return true;
+}
+
+void SceneTab::StopPlaying()
+{
+    if (!IsPlaying())
+        return;
+
+    scene_->SetUpdateEnabled(false);
+    playSnapshot_.Restore(scene_);
+    playSnapshot_.Clear();
+    // Undo history may refer to nodes created while playing or nodes that restoring removed.
+    undo_.Clear();
+    // Modifications made while playing are discarded.
+    revision_ = playRevision_;
+}
+
+bool SceneTab::WriteScene(Serializer& dest, const String& fileName)
+{
     bool result = false;
 
     float elapsed = 0;
@@ -223,23 +436,292 @@ bool SceneTab::SaveScene(const String& filePath)
         scene_->SetElapsedTime(0);
     }
 
-    if (fullPath.EndsWith(".xml", false))
-        result = scene_->SaveXML(file);
-    else if (fullPath.EndsWith(".json", false))
-        result = scene_->SaveJSON(file);
+    // Contents of prefab instances are recreated from prefabs when scene is loaded.
+    PrefabReference::SetContentTemporary(scene_, true);
+
+    if (fileName.EndsWith(".xml", false))
+        result = scene_->SaveXML(dest);
+    else if (fileName.EndsWith(".json", false))
+        result = scene_->SaveJSON(dest);
+    else if (fileName.EndsWith(".bin", false))
+        result = scene_->Save(dest);
+
+    PrefabReference::SetContentTemporary(scene_, false);
 
     if (!settings_->saveElapsedTime_)
         scene_->SetElapsedTime(elapsed);
 
-    if (result)
+    return result;
+}
+
+void SceneTab::OnSceneModified(VariantMap& args)
+{
+    // Nodes created by async loading and temporary editor objects are not user modifications.
+    if (scene_->IsAsyncLoading())
+        return;
+
+    auto* node = static_cast<Node*>(args[NodeAdded::P_NODE].GetPtr());
+    auto* component = static_cast<Component*>(args[ComponentAdded::P_COMPONENT].GetPtr());
+    if (component != nullptr && (component->IsTemporary() || component->GetNode()->IsTemporary()))
+        return;
+    if (node != nullptr && node->IsTemporary())
+        return;
+
+    SetModified();
+}
+
+void SceneTab::OnInspectorValueModified(VariantMap& args)
+{
+    using namespace AttributeInspectorValueModified;
+    auto* item = static_cast<Serializable*>(args[P_SERIALIZABLE].GetPtr());
+    if (item != nullptr && (item->IsInstanceOf<Node>() || item->IsInstanceOf<Component>()))
+        SetModified();
+}
+
+void SceneTab::UpdateRenderScale()
+{
+    const Matrix3x4& cameraTransform = camera_->GetWorldTransform();
+    bool navigating = gizmo_.IsActive() || cameraTransform != lastCameraTransform_;
+    lastCameraTransform_ = cameraTransform;
+
+    if (!settings_->adaptiveResolution_)
+        SetRenderScale(1.f);
+    else if (navigating)
     {
-        if (!filePath.Empty())
-            path_ = filePath;
+        idleFrames_ = 0;
+        SetRenderScale(settings_->minRenderScale_);
+    }
+    else if (++idleFrames_ >= settings_->idleFrames_)
+        SetRenderScale(1.f);
+}
+
+void SceneTab::UpdateViewSurface()
+{
+    // Unfocused views are throttled. Views hidden behind other dock tabs never get here and are not rendered at all.
+    int fps = settings_->unfocusedFps_;
+    if (!isActive_ && fps > 0 && surfaceUpdateTimer_.GetMSec(false) < 1000u / fps)
+        return;
+
+    surfaceUpdateTimer_.Reset();
+    QueueUpdate();
+}
+
+void SceneTab::RenderLoadingProgress()
+{
+    auto& style = ui::GetStyle();
+    auto barHeight = ui::GetFontSize() + style.FramePadding.y * 2;
+    ImVec2 pos(rect_.left_ + style.WindowPadding.x, rect_.bottom_ - barHeight - style.WindowPadding.y);
+    ui::SetCursorScreenPos(pos);
+
+    // Scene waiting for its turn or being parsed has no progress to report yet.
+    String loadingPath = GetLoadingScenePath();
+    float progress = scene_->IsAsyncLoading() ? scene_->GetAsyncProgress() : 0.f;
+
+    ui::ProgressBar(progress, {rect_.Width() - style.WindowPadding.x * 2, 0},
+        ToString("Loading %s", GetFileName(loadingPath).CString()).CString());
+}
+
+void SceneTab::UpdateSelection()
+{
+    // Gizmo took over the click.
+    if (gizmo_.IsActive())
+    {
+        isSelecting_ = false;
+        return;
+    }
+
+    IntVector2 mousePos = GetInput()->GetMousePosition();
+    IntRect selectionRect(Min(selectionStart_.x_, mousePos.x_), Min(selectionStart_.y_, mousePos.y_),
+        Max(selectionStart_.x_, mousePos.x_), Max(selectionStart_.y_, mousePos.y_));
+    bool isMarquee = selectionRect.Width() > marqueeDragThreshold || selectionRect.Height() > marqueeDragThreshold;
+
+    if (GetInput()->GetMouseButtonDown(MOUSEB_LEFT))
+    {
+        if (isMarquee)
+        {
+            auto* drawList = ui::GetWindowDrawList();
+            drawList->AddRectFilled(ToImGui(selectionRect.Min()), ToImGui(selectionRect.Max()),
+                ui::GetColorU32(ImGuiCol_TextSelectedBg));
+            drawList->AddRect(ToImGui(selectionRect.Min()), ToImGui(selectionRect.Max()),
+                ui::GetColorU32(ImGuiCol_Border));
+        }
+        return;
     }
+
+    isSelecting_ = false;
+    if (isMarquee)
+    {
+        SelectInRect(selectionRect);
+        return;
+    }
+
+    // Modifiers match marquee selection: shift adds to selection, ctrl toggles, otherwise selection is replaced.
+    Node* clickNode = PickNode(selectionStart_);
+    if (GetInput()->GetKeyDown(KEY_CTRL))
+    {
+        if (clickNode != nullptr)
+            ToggleSelection(clickNode);
+    }
+    else if (GetInput()->GetKeyDown(KEY_SHIFT))
+        Select(clickNode);
     else
-        URHO3D_LOGERRORF("Saving scene to %s failed.", resourcePath.CString());
+    {
+        UnselectAll();
+        Select(clickNode);
+    }
+}
 
-    return result;
+void SceneTab::UpdateHoveredNode()
+{
+    if (gizmo_.IsActive() || isSelecting_)
+    {
+        hoveredNode_.Reset();
+        return;
+    }
+
+    IntVector2 mousePos = GetInput()->GetMousePosition();
+    if (mousePos != lastHoverPosition_)
+    {
+        hoveredNode_ = PickNode(mousePos);
+        lastHoverPosition_ = mousePos;
+    }
+
+    if (hoveredNode_.Expired() || IsSelected(hoveredNode_))
+        return;
+
+    if (auto* debug = scene_->GetComponent<DebugRenderer>())
+    {
+        for (auto& component: hoveredNode_->GetComponents())
+        {
+            if (auto* drawable = dynamic_cast<Drawable*>(component.Get()))
+                debug->AddBoundingBox(drawable->GetWorldBoundingBox(), Color::YELLOW);
+        }
+    }
+}
+
+Node* SceneTab::PickNode(const IntVector2& screenPos)
+{
+    auto* octree = scene_->GetComponent<Octree>();
+    if (octree == nullptr)
+        return nullptr;
+
+    IntVector2 pos = screenPos - rect_.Min();
+    Ray cameraRay = GetCamera()->GetScreenRay((float)pos.x_ / rect_.Width(), (float)pos.y_ / rect_.Height());
+    // Pick only geometry objects, not eg. zones or lights. Candidates are sorted by distance to their bounding box.
+    PODVector<RayQueryResult> results;
+    RayOctreeQuery query(results, cameraRay, RAY_AABB, M_INFINITY, DRAWABLE_GEOMETRY);
+    octree->Raycast(query);
+
+    auto* bvhCache = GetSubsystem<ModelBVHCache>();
+    Drawable* closest = nullptr;
+    float closestDistance = M_INFINITY;
+    for (const auto& result: results)
+    {
+        // Remaining drawables are farther than the closest hit.
+        if (result.distance_ >= closestDistance)
+            break;
+
+        float distance = M_INFINITY;
+        if (!bvhCache->HitDistance(result.drawable_, cameraRay, distance))
+        {
+            // Triangle hierarchy is not available yet, use engine raycast.
+            PODVector<RayQueryResult> hits;
+            RayOctreeQuery triangleQuery(hits, cameraRay, RAY_TRIANGLE, closestDistance, DRAWABLE_GEOMETRY);
+            result.drawable_->ProcessRayQuery(triangleQuery, hits);
+            for (const auto& hit: hits)
+                distance = Min(distance, hit.distance_);
+        }
+
+        if (distance < closestDistance)
+        {
+            closestDistance = distance;
+            closest = result.drawable_;
+        }
+    }
+
+    if (closest == nullptr)
+    {
+        // When object geometry was not hit by a ray - query for object bounding box.
+        RayOctreeQuery query2(results, cameraRay, RAY_OBB, M_INFINITY, DRAWABLE_GEOMETRY);
+        octree->RaycastSingle(query2);
+        if (results.Size())
+            closest = results[0].drawable_;
+    }
+
+    return closest != nullptr ? closest->GetNode() : nullptr;
+}
+
+void SceneTab::SelectInRect(const IntRect& screenRect)
+{
+    auto* octree = scene_->GetComponent<Octree>();
+    if (octree == nullptr)
+        return;
+
+    // Build a sub-frustum of the camera from rays passing through corners of selection rectangle. Corner order
+    // matches Frustum::Define(): top-right, bottom-right, bottom-left, top-left.
+    Camera* camera = GetCamera();
+    Vector3 forward = camera->GetNode()->GetWorldDirection();
+    const IntVector2 corners[] = {
+        {screenRect.right_, screenRect.top_}, {screenRect.right_, screenRect.bottom_},
+        {screenRect.left_, screenRect.bottom_}, {screenRect.left_, screenRect.top_}
+    };
+    Frustum frustum;
+    for (unsigned i = 0; i < 4; i++)
+    {
+        IntVector2 pos = corners[i] - rect_.Min();
+        Ray ray = camera->GetScreenRay(Clamp((float)pos.x_ / rect_.Width(), 0.f, 1.f),
+            Clamp((float)pos.y_ / rect_.Height(), 0.f, 1.f));
+        float farDistance = camera->GetFarClip() / Max(ray.direction_.DotProduct(forward), M_EPSILON);
+        frustum.vertices_[i] = ray.origin_;
+        frustum.vertices_[i + 4] = ray.origin_ + ray.direction_ * farDistance;
+    }
+    frustum.UpdatePlanes();
+
+    PODVector<Drawable*> drawables;
+    FrustumOctreeQuery query(drawables, frustum, DRAWABLE_GEOMETRY);
+    octree->GetDrawables(query);
+
+    // Node may own multiple drawables.
+    HashSet<Node*> uniqueNodes;
+    PODVector<Node*> nodes;
+    nodes.Reserve(drawables.Size());
+    for (Drawable* drawable: drawables)
+    {
+        Node* node = drawable->GetNode();
+        if (node == nullptr || node->IsTemporary() || uniqueNodes.Contains(node))
+            continue;
+        uniqueNodes.Insert(node);
+        nodes.Push(node);
+    }
+
+    // Modifiers match click selection: shift adds to selection, ctrl toggles, otherwise selection is replaced.
+    bool changed = false;
+    if (GetInput()->GetKeyDown(KEY_CTRL))
+    {
+        PODVector<Node*> selected;
+        PODVector<Node*> unselected;
+        for (Node* node: nodes)
+        {
+            if (gizmo_.IsSelected(node))
+                selected.Push(node);
+            else
+                unselected.Push(node);
+        }
+        changed = gizmo_.Unselect(selected);
+        changed |= gizmo_.Select(unselected);
+    }
+    else
+    {
+        if (!GetInput()->GetKeyDown(KEY_SHIFT))
+            changed = gizmo_.UnselectAll();
+        changed |= gizmo_.Select(nodes);
+    }
+
+    if (changed)
+    {
+        using namespace EditorSelectionChanged;
+        SendEvent(E_EDITORSELECTIONCHANGED, P_SCENETAB, this);
+    }
 }
 
 void SceneTab::CreateObjects()
@@ -343,6 +825,248 @@ void SceneTab::RenderGizmoButtons()
         ui::SetTooltip("Camera Headlight");
 }
 
+void SceneTab::CopySelection()
+{
+    PODVector<Node*> nodes;
+    for (auto& node: GetSelection())
+    {
+        if (!node.Expired())
+            nodes.Push(node.Get());
+    }
+    GetSubsystem<NodeClipboard>()->Copy(nodes);
+}
+
+void SceneTab::PasteClipboard()
+{
+    auto* clipboard = GetSubsystem<NodeClipboard>();
+    if (clipboard->IsEmpty())
+        return;
+
+    Node* parent = scene_;
+    const auto& selection = GetSelection();
+    if (!selection.Empty() && !selection.Front().Expired() && selection.Front()->GetParent() != nullptr)
+        parent = selection.Front()->GetParent();
+
+    PODVector<Node*> created;
+    clipboard->Paste(parent, 1, created);
+    SelectCreatedNodes(created);
+}
+
+void SceneTab::DuplicateSelection(unsigned count)
+{
+    PODVector<Node*> nodes;
+    for (auto& node: GetSelection())
+    {
+        if (!node.Expired())
+            nodes.Push(node.Get());
+    }
+    if (nodes.Empty() || count == 0)
+        return;
+
+    PODVector<Node*> created;
+    GetSubsystem<NodeClipboard>()->Duplicate(nodes, count, created);
+    SelectCreatedNodes(created);
+}
+
+void SceneTab::SelectCreatedNodes(const PODVector<Node*>& nodes)
+{
+    if (nodes.Empty())
+        return;
+
+    undo_.TrackCreation(nodes);
+    gizmo_.UnselectAll();
+    gizmo_.Select(nodes);
+
+    using namespace EditorSelectionChanged;
+    SendEvent(E_EDITORSELECTIONCHANGED, P_SCENETAB, this);
+}
+
+void SceneTab::InstantiatePrefab(const String& resourceName)
+{
+    Node* node = scene_->CreateChild(GetFileName(resourceName));
+    node->CreateComponent<PrefabReference>()->SetPrefab(resourceName);
+
+    PODVector<Node*> created;
+    created.Push(node);
+    SelectCreatedNodes(created);
+}
+
+bool SceneTab::CreatePrefab(const String& fileName)
+{
+    const auto& selection = GetSelection();
+    if (selection.Empty() || selection.Front().Expired() || selection.Front().Get() == scene_.Get())
+        return false;
+    Node* node = selection.Front();
+
+    // Prefab is referenced by resource name, so it has to be saved to a resource directory.
+    String resourceName;
+    String fullPath = GetInternalPath(fileName);
+    for (const String& directory: GetCache()->GetResourceDirs())
+    {
+        if (fullPath.StartsWith(directory, false))
+        {
+            resourceName = fullPath.Substring(directory.Length());
+            break;
+        }
+    }
+    if (resourceName.Empty())
+    {
+        URHO3D_LOGERRORF("Prefab %s must be saved to a resource directory", fileName.CString());
+        return false;
+    }
+
+    bool saved;
+    {
+        PrefabReference::SetContentTemporary(node, true);
+        File file(context_, fullPath, FILE_WRITE);
+        saved = file.IsOpen() && node->SaveXML(file);
+        PrefabReference::SetContentTemporary(node, false);
+    }
+    if (!saved)
+    {
+        URHO3D_LOGERRORF("Saving prefab %s failed", fileName.CString());
+        return false;
+    }
+
+    // Existing contents become the instance, so they keep their ids and references to them stay valid while editing.
+    auto* prefab = node->CreateComponent<PrefabReference>();
+    if (!prefab->AdoptPrefab(resourceName))
+    {
+        prefab->Remove();
+        URHO3D_LOGERRORF("Contents of node do not match saved prefab %s", resourceName.CString());
+        return false;
+    }
+
+    PODVector<Component*> created;
+    created.Push(prefab);
+    undo_.TrackCreation(created);
+
+    unsigned numReferences = CountOutsideReferences(node);
+    if (numReferences > 0)
+    {
+        URHO3D_LOGWARNINGF("Prefab instance %s contents are referenced %u times from outside of the instance. These "
+            "references will break when scene is reloaded, because prefab contents are recreated with new ids.",
+            resourceName.CString(), numReferences);
+    }
+    return true;
+}
+
+unsigned SceneTab::CountOutsideReferences(Node* root) const
+{
+    // Contents of root node, root node itself is not replaced.
+    HashSet<unsigned> nodeIds;
+    HashSet<unsigned> componentIds;
+    PODVector<Node*> children;
+    root->GetChildren(children, true);
+    for (Node* child: children)
+        nodeIds.Insert(child->GetID());
+    children.Push(root);
+    for (Node* child: children)
+    {
+        for (auto& component: child->GetComponents())
+            componentIds.Insert(component->GetID());
+    }
+
+    auto countReferences = [&](Serializable* item) {
+        unsigned count = 0;
+        const Vector<AttributeInfo>* attributes = item->GetAttributes();
+        if (attributes == nullptr)
+            return count;
+
+        for (unsigned i = 0; i < attributes->Size(); i++)
+        {
+            unsigned mode = attributes->At(i).mode_;
+            if (mode & AM_NODEID)
+                count += nodeIds.Contains(item->GetAttribute(i).GetUInt()) ? 1 : 0;
+            else if (mode & AM_COMPONENTID)
+                count += componentIds.Contains(item->GetAttribute(i).GetUInt()) ? 1 : 0;
+            else if (mode & AM_NODEIDVECTOR)
+            {
+                // First element is number of ids.
+                Variant value = item->GetAttribute(i);
+                const VariantVector& ids = value.GetVariantVector();
+                for (unsigned j = 1; j < ids.Size(); j++)
+                    count += nodeIds.Contains(ids[j].GetUInt()) ? 1 : 0;
+            }
+        }
+        return count;
+    };
+
+    unsigned count = 0;
+    PODVector<Node*> nodes;
+    scene_->GetChildren(nodes, true);
+    nodes.Push(scene_);
+    for (Node* node: nodes)
+    {
+        if (node == root || node->IsChildOf(root))
+            continue;
+        count += countReferences(node);
+        for (auto& component: node->GetComponents())
+            count += countReferences(component);
+    }
+    return count;
+}
+
+bool SceneTab::ApplyPrefab()
+{
+    PrefabReference* prefab = GetSelectedPrefab();
+    return prefab != nullptr && prefab->SavePrefab();
+}
+
+PrefabReference* SceneTab::GetSelectedPrefab() const
+{
+    const auto& selection = GetSelection();
+    if (selection.Empty() || selection.Front().Expired())
+        return nullptr;
+    return selection.Front()->GetComponent<PrefabReference>();
+}
+
+void SceneTab::Undo()
+{
+    undo_.Undo();
+    UnselectDetachedNodes();
+}
+
+void SceneTab::Redo()
+{
+    undo_.Redo();
+    UnselectDetachedNodes();
+}
+
+void SceneTab::UnselectDetachedNodes()
+{
+    PODVector<Node*> detached;
+    for (auto& node: GetSelection())
+    {
+        if (!node.Expired() && node->GetScene() != scene_)
+            detached.Push(node.Get());
+    }
+
+    if (gizmo_.Unselect(detached))
+    {
+        using namespace EditorSelectionChanged;
+        SendEvent(E_EDITORSELECTIONCHANGED, P_SCENETAB, this);
+    }
+}
+
+void SceneTab::HandleEditShortcuts()
+{
+    auto* input = GetInput();
+    if (!input->GetKeyDown(KEY_CTRL))
+        return;
+
+    if (input->GetKeyPress(KEY_C))
+        CopySelection();
+    else if (input->GetKeyPress(KEY_V))
+        PasteClipboard();
+    else if (input->GetKeyPress(KEY_D))
+        DuplicateSelection();
+    else if (input->GetKeyPress(KEY_Y) || (input->GetKeyDown(KEY_SHIFT) && input->GetKeyPress(KEY_Z)))
+        Redo();
+    else if (input->GetKeyPress(KEY_Z))
+        Undo();
+}
+
 bool SceneTab::IsSelected(Node* node) const
 {
     return gizmo_.IsSelected(node);
@@ -376,6 +1100,12 @@ void SceneTab::RenderInspector()
         if (node == scene_)
         {
             effectSettings_->Prepare();
+            // Effect attributes are rebuilt in place, cached filter results would point to wrong attributes.
+            if (effectsAttributesVersion_ != effectSettings_->GetAttributesVersion())
+            {
+                inspector_.ClearFilterCache();
+                effectsAttributesVersion_ = effectSettings_->GetAttributesVersion();
+            }
             items.Push(settings_.Get());
             items.Push(effectSettings_.Get());
         }
@@ -385,11 +1115,30 @@ void SceneTab::RenderInspector()
     }
 }
 
+void SceneTab::RenderStatistics()
+{
+    statistics_.RenderUI();
+}
+
 void SceneTab::RenderSceneNodeTree(Node* node)
 {
     ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow;
     if (node == nullptr)
     {
+        ui::PushID("HierarchyFilter");
+        ui::PushItemWidth(-1);
+        ui::InputText("", &hierarchyFilter_.front(), hierarchyFilter_.size() - 1);
+        if (ui::IsItemActive() && ui::IsKeyPressed(ImGuiKey_Escape))
+            hierarchyFilter_.front() = 0;
+        ui::PopItemWidth();
+        ui::PopID();
+
+        if (hierarchyFilter_.front() != 0)
+        {
+            RenderSearchResults();
+            return;
+        }
+
         flags |= ImGuiTreeNodeFlags_DefaultOpen;
         node = scene_;
     }
@@ -403,8 +1152,17 @@ void SceneTab::RenderSceneNodeTree(Node* node)
     if (isSelected)
         flags |= ImGuiTreeNodeFlags_Selected;
 
+    if (!revealNode_.Expired() && revealNode_->IsChildOf(node))
+        ui::SetNextTreeNodeOpen(true);
+
     auto opened = ui::TreeNodeEx(name.CString(), flags);
 
+    if (revealNode_ == node)
+    {
+        ui::SetScrollHere();
+        revealNode_.Reset();
+    }
+
     if (ui::IsItemClicked(0))
     {
         if (!GetInput()->GetKeyDown(KEY_CTRL))
@@ -434,11 +1192,107 @@ void SceneTab::RenderSceneNodeTree(Node* node)
     }
 }
 
+void SceneTab::RenderSearchResults()
+{
+    String pattern = &hierarchyFilter_.front();
+    if (pattern != searchPattern_ || searchRevision_ != searchIndex_.GetRevision())
+    {
+        UpdateSearchRows(pattern);
+        searchPattern_ = pattern;
+        searchRevision_ = searchIndex_.GetRevision();
+    }
+
+    // All rows are expanded, so tree can be clipped as a flat list of rows.
+    const float indentSpacing = ui::GetStyle().IndentSpacing;
+    ImGuiListClipper clipper(searchRows_.Size(), ui::GetTextLineHeightWithSpacing());
+    while (clipper.Step())
+    {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+        {
+            const SearchRow& row = searchRows_[i];
+            Node* node = scene_->GetNode(row.id_);
+            if (node == nullptr)
+                continue;
+
+            ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+            if (row.hasChildren_)
+                ui::SetNextTreeNodeOpen(true);
+            else
+                flags |= ImGuiTreeNodeFlags_Leaf;
+            if (IsSelected(node))
+                flags |= ImGuiTreeNodeFlags_Selected;
+
+            String name = ToString("%s (%d)", (node->GetName().Empty() ? node->GetTypeName() : node->GetName()).CString(),
+                node->GetID());
+            ui::PushID(node->GetID());
+            if (row.depth_ > 0)
+                ui::Indent(row.depth_ * indentSpacing);
+            // Ancestors are shown only to give matches their hierarchy context.
+            if (!row.matched_)
+                ui::PushStyleColor(ImGuiCol_Text, ui::GetStyle().Colors[ImGuiCol_TextDisabled]);
+            ui::TreeNodeEx(name.CString(), flags);
+            if (!row.matched_)
+                ui::PopStyleColor();
+
+            if (ui::IsItemClicked(0))
+            {
+                if (!GetInput()->GetKeyDown(KEY_CTRL))
+                    UnselectAll();
+                ToggleSelection(node);
+                revealNode_ = node;
+            }
+
+            // Double click clears filter and shows node in hierarchy tree.
+            if (ui::IsItemHovered() && ui::IsMouseDoubleClicked(0))
+                hierarchyFilter_.front() = 0;
+
+            if (row.depth_ > 0)
+                ui::Unindent(row.depth_ * indentSpacing);
+            ui::PopID();
+        }
+    }
+}
+
+void SceneTab::UpdateSearchRows(const String& pattern)
+{
+    PODVector<unsigned> matches;
+    searchIndex_.Search(pattern, matches);
+
+    // Visible nodes are matches and all their ancestors.
+    HashMap<Node*, bool> visible;
+    for (unsigned id: matches)
+    {
+        Node* node = scene_->GetNode(id);
+        if (node == nullptr)
+            continue;
+        visible[node] = true;
+        for (Node* parent = node->GetParent(); parent != nullptr && !visible.Contains(parent);
+             parent = parent->GetParent())
+            visible[parent] = false;
+    }
+
+    searchRows_.Clear();
+    if (!visible.Empty())
+        AddSearchRows(scene_, 0, visible);
+}
+
+void SceneTab::AddSearchRows(Node* node, unsigned depth, const HashMap<Node*, bool>& visible)
+{
+    unsigned index = searchRows_.Size();
+    searchRows_.Push({node->GetID(), depth, visible.Find(node)->second_, false});
+    for (auto& child: node->GetChildren())
+    {
+        if (!child->IsTemporary() && visible.Contains(child))
+            AddSearchRows(child, depth + 1, visible);
+    }
+    searchRows_[index].hasChildren_ = searchRows_.Size() > index + 1;
+}
+
 void SceneTab::LoadProject(XMLElement scene)
 {
     id_ = StringHash(ToUInt(scene.GetAttribute("id"), 16));
     SetTitle(scene.GetAttribute("title"));
-    LoadScene(scene.GetAttribute("path"));
+    LoadSceneDeferred(scene.GetAttribute("path"));
 
     auto camera = scene.GetChild("camera");
     if (camera.NotNull())
@@ -459,7 +1313,8 @@ void SceneTab::SaveProject(XMLElement scene) const
 {
     scene.SetAttribute("id", id_.ToString().CString());
     scene.SetAttribute("title", title_);
-    scene.SetAttribute("path", path_);
+    // Scene which did not finish loading yet has no path, but it still belongs to the project.
+    scene.SetAttribute("path", forgetScenePath_ ? path_ : GetLoadingScenePath());
 
     auto camera = scene.CreateChild("camera");
     camera.CreateChild("position").SetVariant(camera_->GetPosition());
@@ -470,6 +1325,34 @@ void SceneTab::SaveProject(XMLElement scene) const
     effectSettings_->SaveProject(scene);
 }
 
+void SceneTab::LoadProject(Deserializer& source)
+{
+    id_ = StringHash(source.ReadUInt());
+    SetTitle(source.ReadString());
+    LoadSceneDeferred(source.ReadString());
+
+    camera_->SetPosition(source.ReadVector3());
+    camera_->SetRotation(source.ReadQuaternion());
+    camera_->GetComponent<Light>()->SetEnabled(source.ReadBool());
+
+    settings_->LoadProject(source);
+    effectSettings_->LoadProject(source);
+}
+
+void SceneTab::SaveProject(Serializer& dest) const
+{
+    dest.WriteUInt(id_.Value());
+    dest.WriteString(title_);
+    dest.WriteString(forgetScenePath_ ? path_ : GetLoadingScenePath());
+
+    dest.WriteVector3(camera_->GetPosition());
+    dest.WriteQuaternion(camera_->GetRotation());
+    dest.WriteBool(camera_->GetComponent<Light>()->IsEnabled());
+
+    settings_->SaveProject(dest);
+    effectSettings_->SaveProject(dest);
+}
+
 void SceneTab::SetTitle(const String& title)
 {
     title_ = title;
@@ -479,6 +1362,8 @@ void SceneTab::SetTitle(const String& title)
 void SceneTab::ClearCachedPaths()
 {
     path_.Clear();
+    // Scene which did not start loading yet would remember its path once loaded.
+    forgetScenePath_ = IsLoadPending() || parseItem_.NotNull();
 }
 
 }
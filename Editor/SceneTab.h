@@ -28,7 +28,14 @@
 #include <Toolbox/SystemUI/AttributeInspector.h>
 #include <Toolbox/SystemUI/Gizmo.h>
 #include <Toolbox/SystemUI/ImGuiDock.h>
+#include <Toolbox/Graphics/ModelBVHCache.h>
 #include <Toolbox/Graphics/SceneView.h>
+#include <Toolbox/Common/UndoManager.h>
+#include <Toolbox/Scene/NodeClipboard.h>
+#include <Toolbox/Scene/NodeSearchIndex.h>
+#include <Toolbox/Scene/Prefab.h>
+#include <Toolbox/Scene/SceneSnapshot.h>
+#include <Toolbox/Scene/SceneStatistics.h>
 #include "IDPool.h"
 
 namespace Urho3D
@@ -51,12 +58,48 @@ public:
     bool RenderWindow();
     /// Render inspector window.
     void RenderInspector();
-    /// Render scene hierarchy window.
+    /// Render scene statistics window.
+    void RenderStatistics();
+    /// Render scene hierarchy window. When hierarchy filter is set, matching nodes are listed instead of the tree.
     void RenderSceneNodeTree(Node* node=nullptr);
-    /// Load scene from xml or json file.
+    /// Load scene from xml, json or binary file. Xml and binary scenes are loaded over multiple frames, json scenes are
+    /// parsed on a worker thread.
     void LoadScene(const String& filePath);
+    /// Remember scene file which should be loaded when editor calls StartPendingLoad().
+    void LoadSceneDeferred(const String& filePath) { pendingScenePath_ = filePath; }
+    /// Return true if scene load was deferred and is not started yet.
+    bool IsLoadPending() const { return !pendingScenePath_.Empty(); }
+    /// Start loading scene passed to LoadSceneDeferred().
+    void StartPendingLoad();
+    /// Return true while scene is waiting to be loaded, parsed or loaded asynchronously.
+    bool IsLoading() const;
+    /// Drop deferred scene load and stop parsing json scene. Scene which is already loading asynchronously is not
+    /// affected.
+    void CancelLoading();
+    /// Return path of scene that is waiting to be loaded or parsed, or resource path of current scene.
+    String GetLoadingScenePath() const;
+    /// Instantiate scene once worker thread finished parsing it. Should be called once per frame.
+    void UpdateLoading();
     /// Save scene to a resource file.
     bool SaveScene(const String& filePath = "");
+    /// Save scene in binary format to a memory buffer or stream. Scene path and modification state are not changed.
+    bool SaveSceneSnapshot(Serializer& dest);
+    /// Load scene from binary snapshot. Scene will be saved to scenePath and is marked as modified.
+    bool LoadSceneSnapshot(Deserializer& source, const String& scenePath);
+    /// Return resource path of scene file.
+    const String& GetScenePath() const { return path_; }
+    /// Return number of modifications made to the scene since tab was created.
+    unsigned GetRevision() const { return revision_; }
+    /// Return true if scene has modifications which were not saved yet.
+    bool IsModified() const { return revision_ != savedRevision_; }
+    /// Register modification of the scene.
+    void SetModified() { revision_++; }
+    /// Snapshot the scene and start updating it. Returns false if scene is loading or already playing.
+    bool StartPlaying();
+    /// Stop updating the scene and restore it to the state it had when playing started.
+    void StopPlaying();
+    /// Return true if scene is being played.
+    bool IsPlaying() const { return !playSnapshot_.IsEmpty(); }
 
     /// Add a node to selection.
     void Select(Node* node);
@@ -70,12 +113,38 @@ public:
     bool IsSelected(Node* node) const;
     /// Return list of selected nodes.
     const Vector<WeakPtr<Node>>& GetSelection() const;
+    /// Return selection version. It changes every time selection changes.
+    unsigned GetSelectionVersion() const { return gizmo_.GetSelectionVersion(); }
     /// Render buttons which customize gizmo behavior.
     void RenderGizmoButtons();
+    /// Copy selected nodes to editor clipboard.
+    void CopySelection();
+    /// Paste nodes from editor clipboard next to the first selected node or to the scene root. Pasted nodes are
+    /// selected.
+    void PasteClipboard();
+    /// Create count copies of selected nodes next to them as a single undo step. Copies are selected.
+    void DuplicateSelection(unsigned count = 1);
+    /// Create instance of prefab resource as a child of scene root and select it.
+    void InstantiatePrefab(const String& resourceName);
+    /// Save first selected node as a prefab to a file in one of resource directories and make node contents an
+    /// instance of that prefab. Adding of prefab reference can be undone.
+    bool CreatePrefab(const String& fileName);
+    /// Save contents of first selected prefab instance to its prefab. Other instances are updated.
+    bool ApplyPrefab();
+    /// Return prefab reference of first selected node or null.
+    PrefabReference* GetSelectedPrefab() const;
+    /// Undo last scene modification tracked by scene tab.
+    void Undo();
+    /// Redo last undone scene modification.
+    void Redo();
     /// Save project data to xml.
     void SaveProject(XMLElement scene) const;
     /// Load project data from xml.
     void LoadProject(XMLElement scene);
+    /// Save project data to binary project file.
+    void SaveProject(Serializer& dest) const;
+    /// Load project data from binary project file.
+    void LoadProject(Deserializer& source);
     /// Set scene view tab title.
     void SetTitle(const String& title);
     /// Get scene view tab title.
@@ -92,10 +161,62 @@ public:
     bool IsRendered() const { return isRendered_; }
 
 protected:
+    /// Single row of filtered hierarchy tree.
+    struct SearchRow
+    {
+        /// Node id.
+        unsigned id_;
+        /// Depth of node in the tree, scene root is at depth 0.
+        unsigned depth_;
+        /// Flag indicating that node matches filter. Other rows are ancestors of matching nodes.
+        bool matched_;
+        /// Flag indicating that node has visible children.
+        bool hasChildren_;
+    };
+
     /// Called when node selection changes.
     void OnNodeSelectionChanged();
     /// Creates scene camera and other objects required by editor.
     void CreateObjects() override;
+    /// Lower rendering resolution while camera or gizmo are moving and restore it when view is idle.
+    void UpdateRenderScale();
+    /// Queue rendering of scene view if it is focused or throttling interval of unfocused view has passed.
+    void UpdateViewSurface();
+    /// Resolve pending click or marquee selection and render selection rectangle while mouse is dragged.
+    void UpdateSelection();
+    /// Pick node under mouse cursor when it moves and highlight its bounding boxes.
+    void UpdateHoveredNode();
+    /// Return node of closest drawable under specified screen position or null. Triangles of static models are tested
+    /// using cached triangle hierarchies.
+    Node* PickNode(const IntVector2& screenPos);
+    /// Select nodes of drawables inside specified screen rectangle. Holding shift adds to selection, holding ctrl
+    /// toggles selection of nodes inside the rectangle.
+    void SelectInRect(const IntRect& screenRect);
+    /// Handle copy, paste, duplicate, undo and redo keyboard shortcuts.
+    void HandleEditShortcuts();
+    /// Track creation of nodes for undo and select them instead of current selection.
+    void SelectCreatedNodes(const PODVector<Node*>& nodes);
+    /// Unselect nodes that were removed from the scene but are kept alive by undo history.
+    void UnselectDetachedNodes();
+    /// Return number of node and component id attributes outside of root node that refer to its children or
+    /// components.
+    unsigned CountOutsideReferences(Node* root) const;
+    /// Render hierarchy tree of nodes matching hierarchy filter and their ancestors. Tree is fully expanded.
+    void RenderSearchResults();
+    /// Find nodes matching hierarchy filter and rebuild rows of filtered tree.
+    void UpdateSearchRows(const String& pattern);
+    /// Append row of node and rows of its visible children. Visible nodes are mapped to true when they match filter.
+    void AddSearchRows(Node* node, unsigned depth, const HashMap<Node*, bool>& visible);
+    /// Render progress bar over scene view while scene is being loaded in the background.
+    void RenderLoadingProgress();
+    /// Call load function which replaces scene contents, then recreate editor objects keeping camera view.
+    bool ReplaceScene(const std::function<bool()>& load);
+    /// Serialize scene in a format matching extension of fileName.
+    bool WriteScene(Serializer& dest, const String& fileName);
+    /// Registers scene modification when nodes or components are added, removed or changed.
+    void OnSceneModified(VariantMap& args);
+    /// Registers scene modification when attribute of node or component is edited in the inspector.
+    void OnInspectorValueModified(VariantMap& args);
 
     /// Unique scene id.
     StringHash id_;
@@ -113,6 +234,30 @@ protected:
     ImGuiWindowFlags windowFlags_ = 0;
     /// Attribute inspector.
     AttributeInspector inspector_;
+    /// Undo history of node creation.
+    UndoManager undo_;
+    /// Index of node names and components used by hierarchy filter.
+    NodeSearchIndex searchIndex_;
+    /// Incrementally updated statistics of scene contents.
+    SceneStatistics statistics_;
+    /// Hierarchy filter text.
+    std::array<char, 0x100> hierarchyFilter_{};
+    /// Pattern that searchRows_ were built for.
+    String searchPattern_;
+    /// Revision of search index that searchRows_ were built with.
+    unsigned searchRevision_ = 0;
+    /// Rows of filtered hierarchy tree in the order they are rendered.
+    PODVector<SearchRow> searchRows_;
+    /// Mouse position where selection started.
+    IntVector2 selectionStart_;
+    /// Flag set while left mouse button pressed over scene view is held.
+    bool isSelecting_ = false;
+    /// Node under mouse cursor.
+    WeakPtr<Node> hoveredNode_;
+    /// Mouse position at which hoveredNode_ was picked.
+    IntVector2 lastHoverPosition_;
+    /// Node whose ancestors should be expanded and which should be scrolled into view in hierarchy tree.
+    WeakPtr<Node> revealNode_;
     /// Current selected component displayed in inspector.
     WeakPtr<Component> selectedComponent_;
     /// Name of sibling dock for initial placement.
@@ -127,6 +272,30 @@ protected:
     SharedPtr<SceneSettings> settings_;
     /// Serializable which handles scene postprocess effect settings.
     SharedPtr<SceneEffects> effectSettings_;
+    /// Version of effect attribute list that inspector filter cache was built for.
+    unsigned effectsAttributesVersion_ = 0;
+    /// Incremented on every scene modification.
+    unsigned revision_ = 0;
+    /// Revision of the scene when it was last loaded or saved.
+    unsigned savedRevision_ = 0;
+    /// Time since scene view was last rendered.
+    Timer surfaceUpdateTimer_;
+    /// Scene file which will be loaded by StartPendingLoad().
+    String pendingScenePath_;
+    /// Json scene file being parsed on a worker thread.
+    SharedPtr<JSONFile> parsedScene_;
+    /// Work item parsing parsedScene_.
+    SharedPtr<WorkItem> parseItem_;
+    /// Flag set when cached paths were cleared before scene load finished. Scene path is not remembered then.
+    bool forgetScenePath_ = false;
+    /// Camera transform on previous frame, used for detecting camera movement.
+    Matrix3x4 lastCameraTransform_;
+    /// Number of frames camera and gizmo did not move.
+    int idleFrames_ = 0;
+    /// Scene state taken when playing started. Empty while scene is edited.
+    SceneSnapshot playSnapshot_;
+    /// Revision of the scene when playing started.
+    unsigned playRevision_ = 0;
 };
 
 };
@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Math/MathDefs.h>
+#include "FuzzyMatch.h"
+
+
+namespace Urho3D
+{
+
+static const int FUZZY_MATCH_BONUS = 1;
+static const int FUZZY_CONSECUTIVE_BONUS = 5;
+static const int FUZZY_WORD_START_BONUS = 8;
+static const int FUZZY_LEADING_PENALTY = -1;
+static const int FUZZY_MAX_LEADING_PENALTY = -5;
+
+bool FuzzyMatch(const String& pattern, const String& text, int* score)
+{
+    int result = 0;
+    unsigned p = 0;
+    int lastMatch = -2;
+
+    for (unsigned t = 0; t < text.Length() && p < pattern.Length(); t++)
+    {
+        char c = text[t];
+        if (ToLower((unsigned)c) != ToLower((unsigned)pattern[p]))
+            continue;
+
+        result += FUZZY_MATCH_BONUS;
+        if (lastMatch == (int)t - 1)
+            result += FUZZY_CONSECUTIVE_BONUS;
+
+        // Start of word is either start of a string, a character after separator or uppercase letter in camel case.
+        char prev = t > 0 ? text[t - 1] : ' ';
+        if (prev == ' ' || prev == '_' || prev == '-' || prev == '/' || prev == '.' ||
+            (IsAlpha((unsigned)c) && ToUpper((unsigned)c) == (unsigned)c && ToLower((unsigned)prev) == (unsigned)prev))
+            result += FUZZY_WORD_START_BONUS;
+
+        if (p == 0)
+            result += Max(FUZZY_MAX_LEADING_PENALTY, FUZZY_LEADING_PENALTY * (int)t);
+
+        lastMatch = t;
+        p++;
+    }
+
+    if (p < pattern.Length())
+        return false;
+
+    if (score != nullptr)
+        *score = result;
+    return true;
+}
+
+}
@@ -195,6 +195,113 @@ String UndoableXMLParentState::ToString() const
     return "UndoableXMLParentState";
 }
 
+UndoableNodesParentState::UndoableNodesParentState(const PODVector<Node*>& nodes, bool attached)
+{
+    for (Node* node: nodes)
+    {
+        nodes_.Push(SharedPtr<Node>(node));
+        parents_.Push(SharedPtr<Node>(attached ? node->GetParent() : nullptr));
+    }
+}
+
+bool UndoableNodesParentState::Apply()
+{
+    if (IsCurrent())
+        return false;
+
+    for (unsigned i = 0; i < nodes_.Size(); i++)
+    {
+        if (nodes_[i]->GetParent() == parents_[i])
+            continue;
+
+        if (parents_[i].NotNull())
+            parents_[i]->AddChild(nodes_[i]);
+        else
+            nodes_[i]->Remove();
+    }
+
+    return true;
+}
+
+bool UndoableNodesParentState::IsCurrent()
+{
+    for (unsigned i = 0; i < nodes_.Size(); i++)
+    {
+        if (nodes_[i]->GetParent() != parents_[i])
+            return false;
+    }
+    return true;
+}
+
+bool UndoableNodesParentState::Equals(UndoableState* other)
+{
+    auto other_ = dynamic_cast<UndoableNodesParentState*>(other);
+
+    if (other_ == nullptr)
+        return false;
+
+    return nodes_ == other_->nodes_ && parents_ == other_->parents_;
+}
+
+String UndoableNodesParentState::ToString() const
+{
+    return "UndoableNodesParentState";
+}
+
+UndoableComponentsParentState::UndoableComponentsParentState(const PODVector<Component*>& components, bool attached)
+{
+    for (Component* component: components)
+    {
+        components_.Push(SharedPtr<Component>(component));
+        nodes_.Push(SharedPtr<Node>(attached ? component->GetNode() : nullptr));
+        modes_.Push(component->IsReplicated() ? REPLICATED : LOCAL);
+    }
+}
+
+bool UndoableComponentsParentState::Apply()
+{
+    if (IsCurrent())
+        return false;
+
+    for (unsigned i = 0; i < components_.Size(); i++)
+    {
+        if (components_[i]->GetNode() == nodes_[i])
+            continue;
+
+        if (nodes_[i].NotNull())
+            nodes_[i]->AddComponent(components_[i], 0, modes_[i]);
+        else
+            components_[i]->Remove();
+    }
+
+    return true;
+}
+
+bool UndoableComponentsParentState::IsCurrent()
+{
+    for (unsigned i = 0; i < components_.Size(); i++)
+    {
+        if (components_[i]->GetNode() != nodes_[i])
+            return false;
+    }
+    return true;
+}
+
+bool UndoableComponentsParentState::Equals(UndoableState* other)
+{
+    auto other_ = dynamic_cast<UndoableComponentsParentState*>(other);
+
+    if (other_ == nullptr)
+        return false;
+
+    return components_ == other_->components_ && nodes_ == other_->nodes_;
+}
+
+String UndoableComponentsParentState::ToString() const
+{
+    return "UndoableComponentsParentState";
+}
+
 UndoManager::UndoManager(Context* ctx) : Object(ctx)
 {
 
@@ -259,6 +366,44 @@ void UndoManager::TrackState(const XMLElement& element, const Variant& value)
     Track(new UndoableXMLVariantState(element, value));
 }
 
+void UndoManager::TrackCreation(const PODVector<Node*>& nodes)
+{
+    // Created nodes had no parents.
+    Track(new UndoableNodesParentState(nodes, false));
+    // Then they were added to the scene.
+    Track(new UndoableNodesParentState(nodes, true));
+}
+
+void UndoManager::TrackRemoval(const PODVector<Node*>& nodes)
+{
+    // Nodes being removed still have parents.
+    Track(new UndoableNodesParentState(nodes, true));
+    // Then they are removed from the scene.
+    Track(new UndoableNodesParentState(nodes, false));
+}
+
+void UndoManager::TrackCreation(const PODVector<Component*>& components)
+{
+    // Created components had no nodes.
+    Track(new UndoableComponentsParentState(components, false));
+    // Then they were added to nodes.
+    Track(new UndoableComponentsParentState(components, true));
+}
+
+void UndoManager::TrackRemoval(const PODVector<Component*>& components)
+{
+    // Components being removed still have nodes.
+    Track(new UndoableComponentsParentState(components, true));
+    // Then they are removed from nodes.
+    Track(new UndoableComponentsParentState(components, false));
+}
+
+void UndoManager::Clear()
+{
+    stack_.Clear();
+    index_ = -1;
+}
+
 void UndoManager::Track(UndoableState* state)
 {
     assert(state);
@@ -26,6 +26,8 @@
 #include <Urho3D/Container/Vector.h>
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Core/Object.h>
+#include <Urho3D/Scene/Component.h>
+#include <Urho3D/Scene/Node.h>
 #include <Urho3D/Scene/Serializable.h>
 #include <Urho3D/IO/Log.h>
 #include <Urho3D/UI/UI.h>
@@ -136,6 +138,53 @@ public:
     XMLElement parent_;
 };
 
+/// Tracks parent state of multiple scene nodes as one step. Used for tracking adding and removing groups of nodes.
+class UndoableNodesParentState : public UndoableState
+{
+public:
+    /// Construct state of nodes. When attached is false nodes are recorded as removed from the scene.
+    UndoableNodesParentState(const PODVector<Node*>& nodes, bool attached);
+    /// Attach nodes to recorded parents or remove them if they are different and return true if operation was carried
+    /// out.
+    bool Apply() override;
+    /// Return true if all nodes have recorded parents.
+    bool IsCurrent() override;
+    /// Return true if state of this object matches state of specified object.
+    bool Equals(UndoableState* other) override;
+    /// Return string representation of current state.
+    String ToString() const override;
+
+    /// Nodes whose state is saved. References keep removed nodes alive.
+    Vector<SharedPtr<Node>> nodes_;
+    /// Parents of nodes at the time when state was saved. Null for removed nodes.
+    Vector<SharedPtr<Node>> parents_;
+};
+
+/// Tracks owner node state of multiple components as one step. Used for tracking adding and removing groups of
+/// components.
+class UndoableComponentsParentState : public UndoableState
+{
+public:
+    /// Construct state of components. When attached is false components are recorded as removed from their nodes.
+    UndoableComponentsParentState(const PODVector<Component*>& components, bool attached);
+    /// Add components to recorded nodes or remove them if they are different and return true if operation was carried
+    /// out.
+    bool Apply() override;
+    /// Return true if all components belong to recorded nodes.
+    bool IsCurrent() override;
+    /// Return true if state of this object matches state of specified object.
+    bool Equals(UndoableState* other) override;
+    /// Return string representation of current state.
+    String ToString() const override;
+
+    /// Components whose state is saved. References keep removed components alive.
+    Vector<SharedPtr<Component>> components_;
+    /// Nodes owning components at the time when state was saved. Null for removed components.
+    Vector<SharedPtr<Node>> nodes_;
+    /// Create modes of components, removed components lose their ids.
+    PODVector<CreateMode> modes_;
+};
+
 class UndoManager : public Object
 {
     URHO3D_OBJECT(UndoManager, Object);
@@ -160,6 +209,17 @@ public:
     void TrackRemoval(const XMLElement& element);
     /// Track XMLElement state.
     void TrackState(const XMLElement& element, const Variant& value);
+    /// Track creation of scene nodes as a single undo step.
+    void TrackCreation(const PODVector<Node*>& nodes);
+    /// Track removal of scene nodes as a single undo step.
+    void TrackRemoval(const PODVector<Node*>& nodes);
+    /// Track creation of components as a single undo step.
+    void TrackCreation(const PODVector<Component*>& components);
+    /// Track removal of components as a single undo step.
+    void TrackRemoval(const PODVector<Component*>& components);
+    /// Forget all tracked states. Should be called when tracked objects are replaced, for example when new scene is
+    /// loaded.
+    void Clear();
 
 protected:
     /// Track add undoable state to the state stack.
@@ -0,0 +1,357 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+#include <algorithm>
+#include "ModelBVHCache.h"
+
+
+namespace Urho3D
+{
+
+/// Maximal number of triangles in a leaf node.
+static const unsigned maxLeafTriangles = 4;
+/// Size of traversal stack. Hierarchy is split by median, therefore its depth never exceeds log2 of triangle count.
+static const unsigned maxTraversalDepth = 64;
+/// Interval in milliseconds between sweeps of hierarchies whose models were released.
+static const unsigned sweepIntervalMs = 1000;
+
+/// Build triangle hierarchy. Runs on a worker thread.
+static void BuildTriangleBVH(const WorkItem* item, unsigned threadIndex)
+{
+    reinterpret_cast<TriangleBVH*>(item->aux_)->Build();
+}
+
+TriangleBVH::TriangleBVH(Geometry* geometry)
+{
+    const PODVector<VertexElement>* elements = nullptr;
+    SharedArrayPtr<unsigned char> vertexData;
+    SharedArrayPtr<unsigned char> indexData;
+    unsigned vertexSize = 0;
+    unsigned indexSize = 0;
+    geometry->GetRawDataShared(vertexData, vertexSize, indexData, indexSize, elements);
+
+    // Same limitations as Geometry::GetHitDistance().
+    if (vertexData.Null() || elements == nullptr || geometry->GetPrimitiveType() != TRIANGLE_LIST ||
+        VertexBuffer::GetElementOffset(*elements, TYPE_VECTOR3, SEM_POSITION) != 0)
+        return;
+
+    vertexData_ = vertexData;
+    vertexSize_ = vertexSize;
+    if (indexData.NotNull())
+    {
+        indexData_ = indexData;
+        indexSize_ = indexSize;
+        start_ = geometry->GetIndexStart();
+        count_ = geometry->GetIndexCount();
+    }
+    else
+    {
+        start_ = geometry->GetVertexStart();
+        count_ = geometry->GetVertexCount();
+    }
+}
+
+void TriangleBVH::Build()
+{
+    if (vertexData_.Null())
+        return;
+
+    auto getVertex = [this](unsigned i) -> const Vector3& {
+        unsigned vertex = start_ + i;
+        if (indexData_.NotNull())
+        {
+            const unsigned char* index = indexData_.Get() + vertex * indexSize_;
+            vertex = indexSize_ == sizeof(unsigned short) ? *reinterpret_cast<const unsigned short*>(index) :
+                *reinterpret_cast<const unsigned*>(index);
+        }
+        return *reinterpret_cast<const Vector3*>(vertexData_.Get() + vertex * vertexSize_);
+    };
+
+    unsigned numTriangles = count_ / 3;
+    PODVector<Vector3> vertices(numTriangles * 3);
+    PODVector<Vector3> centers(numTriangles);
+    PODVector<unsigned> order(numTriangles);
+    for (unsigned i = 0; i < numTriangles; i++)
+    {
+        vertices[i * 3] = getVertex(i * 3);
+        vertices[i * 3 + 1] = getVertex(i * 3 + 1);
+        vertices[i * 3 + 2] = getVertex(i * 3 + 2);
+        centers[i] = (vertices[i * 3] + vertices[i * 3 + 1] + vertices[i * 3 + 2]) / 3.f;
+        order[i] = i;
+    }
+
+    // Data is owned by geometry, there is no need to keep it alive.
+    vertexData_.Reset();
+    indexData_.Reset();
+
+    if (numTriangles == 0)
+        return;
+
+    nodes_.Reserve(numTriangles / maxLeafTriangles * 2 + 1);
+    nodes_.Resize(1);
+    BuildNode(0, 0, numTriangles, order, vertices, centers);
+
+    triangles_.Resize(numTriangles * 3);
+    for (unsigned i = 0; i < numTriangles; i++)
+    {
+        for (unsigned j = 0; j < 3; j++)
+            triangles_[i * 3 + j] = vertices[order[i] * 3 + j];
+    }
+}
+
+void TriangleBVH::BuildNode(unsigned nodeIndex, unsigned start, unsigned end, PODVector<unsigned>& order,
+    const PODVector<Vector3>& vertices, const PODVector<Vector3>& centers)
+{
+    if (end - start <= maxLeafTriangles)
+    {
+        BoundingBox bounds;
+        for (unsigned i = start; i < end; i++)
+            bounds.Merge(&vertices[order[i] * 3], 3);
+
+        BVHNode& node = nodes_[nodeIndex];
+        node.first_ = start;
+        node.count_ = end - start;
+        node.bounds_ = bounds;
+        return;
+    }
+
+    BoundingBox centerBounds;
+    for (unsigned i = start; i < end; i++)
+        centerBounds.Merge(centers[order[i]]);
+
+    // Split by median of triangle centers along the longest axis.
+    Vector3 size = centerBounds.Size();
+    unsigned axis = size.x_ > size.y_ ? (size.x_ > size.z_ ? 0 : 2) : (size.y_ > size.z_ ? 1 : 2);
+    unsigned middle = (start + end) / 2;
+    std::nth_element(order.Begin() + start, order.Begin() + middle, order.Begin() + end,
+        [&centers, axis](unsigned a, unsigned b) { return centers[a].Data()[axis] < centers[b].Data()[axis]; });
+
+    unsigned left = nodes_.Size();
+    nodes_.Resize(left + 2);
+    nodes_[nodeIndex].first_ = left;
+    nodes_[nodeIndex].count_ = 0;
+    BuildNode(left, start, middle, order, vertices, centers);
+    BuildNode(left + 1, middle, end, order, vertices, centers);
+
+    BoundingBox bounds(nodes_[left].bounds_);
+    bounds.Merge(nodes_[left + 1].bounds_);
+    nodes_[nodeIndex].bounds_ = bounds;
+}
+
+float TriangleBVH::HitDistance(const Ray& ray) const
+{
+    if (nodes_.Empty())
+        return M_INFINITY;
+
+    float closest = M_INFINITY;
+    unsigned stack[maxTraversalDepth];
+    unsigned stackSize = 0;
+    if (ray.HitDistance(nodes_[0].bounds_) < M_INFINITY)
+        stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const BVHNode& node = nodes_[stack[--stackSize]];
+        if (node.count_ > 0)
+        {
+            const Vector3* vertex = &triangles_[node.first_ * 3];
+            for (unsigned i = 0; i < node.count_; i++, vertex += 3)
+                closest = Min(closest, ray.HitDistance(vertex[0], vertex[1], vertex[2]));
+            continue;
+        }
+
+        float leftDistance = ray.HitDistance(nodes_[node.first_].bounds_);
+        float rightDistance = ray.HitDistance(nodes_[node.first_ + 1].bounds_);
+        // Push farther child first so that closer one is visited first and can cull the other.
+        if (leftDistance < rightDistance)
+        {
+            if (rightDistance < closest)
+                stack[stackSize++] = node.first_ + 1;
+            if (leftDistance < closest)
+                stack[stackSize++] = node.first_;
+        }
+        else
+        {
+            if (leftDistance < closest)
+                stack[stackSize++] = node.first_;
+            if (rightDistance < closest)
+                stack[stackSize++] = node.first_ + 1;
+        }
+    }
+    return closest;
+}
+
+ModelBVHCache::ModelBVHCache(Context* context)
+    : Object(context)
+{
+}
+
+ModelBVHCache::~ModelBVHCache()
+{
+    for (auto it = entries_.Begin(); it != entries_.End(); it++)
+        Complete(it->second_);
+}
+
+TriangleBVH* ModelBVHCache::GetBVH(Model* model, unsigned geometryIndex)
+{
+    if (sweepTimer_.GetMSec(false) >= sweepIntervalMs)
+    {
+        sweepTimer_.Reset();
+        SweepExpired();
+    }
+
+    auto it = entries_.Find(model);
+    Entry* entry;
+    if (it == entries_.End())
+        entry = &CreateEntry(model);
+    else if (it->second_.model_.Get() != model)
+    {
+        // Address of expired model was reused.
+        Complete(it->second_);
+        entries_.Erase(it);
+        entry = &CreateEntry(model);
+    }
+    else
+        entry = &it->second_;
+
+    if (geometryIndex >= entry->geometries_.Size() || !entry->items_[geometryIndex]->completed_)
+        return nullptr;
+    return entry->geometries_[geometryIndex];
+}
+
+bool ModelBVHCache::HitDistance(Drawable* drawable, const Ray& ray, float& distance)
+{
+    // Skinned and instanced models are not supported.
+    if (drawable->GetType() != StaticModel::GetTypeStatic())
+        return false;
+
+    Model* model = static_cast<StaticModel*>(drawable)->GetModel();
+    if (model == nullptr)
+        return false;
+
+    // Hierarchies are in model space. Distance is measured in world space, because node may be scaled.
+    const Matrix3x4& transform = drawable->GetNode()->GetWorldTransform();
+    Ray localRay = ray.Transformed(transform.Inverse());
+    float localDistance = M_INFINITY;
+    for (unsigned i = 0; i < model->GetNumGeometries(); i++)
+    {
+        TriangleBVH* bvh = GetBVH(model, i);
+        if (bvh == nullptr)
+            return false;
+        localDistance = Min(localDistance, bvh->HitDistance(localRay));
+    }
+
+    if (localDistance < M_INFINITY)
+        distance = (transform * (localRay.origin_ + localRay.direction_ * localDistance) - ray.origin_).Length();
+    else
+        distance = M_INFINITY;
+    return true;
+}
+
+ModelBVHCache::Entry& ModelBVHCache::CreateEntry(Model* model)
+{
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    Entry& entry = entries_[model];
+    entry.model_ = model;
+    for (unsigned i = 0; i < model->GetNumGeometries(); i++)
+    {
+        SharedPtr<TriangleBVH> bvh(new TriangleBVH(model->GetGeometry(i, 0)));
+        SharedPtr<WorkItem> item = workQueue->GetFreeItem();
+        item->workFunction_ = BuildTriangleBVH;
+        item->aux_ = bvh.Get();
+        item->priority_ = 0;
+        item->sendEvent_ = false;
+
+        // Without worker threads queued items would wait for somebody to complete the queue.
+        if (workQueue->GetNumThreads() == 0)
+        {
+            BuildTriangleBVH(item, 0);
+            item->completed_ = true;
+        }
+        else
+            workQueue->AddWorkItem(item);
+
+        entry.geometries_.Push(bvh);
+        entry.items_.Push(item);
+    }
+
+    SubscribeToEvent(model, E_RELOADFINISHED, std::bind(&ModelBVHCache::OnModelReloaded, this, std::placeholders::_1,
+        std::placeholders::_2));
+    return entry;
+}
+
+void ModelBVHCache::SweepExpired()
+{
+    for (auto it = entries_.Begin(); it != entries_.End();)
+    {
+        // Hierarchies still being built are referenced by worker threads, they are dropped on one of next sweeps.
+        bool completed = true;
+        for (const auto& item: it->second_.items_)
+            completed &= item->completed_;
+
+        if (it->second_.model_.Expired() && completed)
+            it = entries_.Erase(it);
+        else
+            ++it;
+    }
+}
+
+void ModelBVHCache::Complete(Entry& entry)
+{
+    // Work queue joins its threads when it is destroyed, all items are finished then.
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    if (workQueue == nullptr)
+        return;
+
+    for (const auto& item: entry.items_)
+    {
+        // Items already picked up by worker threads are not waited for by WorkQueue::Complete().
+        while (!item->completed_)
+        {
+            workQueue->Complete(item->priority_);
+            Time::Sleep(0);
+        }
+    }
+}
+
+void ModelBVHCache::OnModelReloaded(StringHash eventType, VariantMap& args)
+{
+    auto* model = static_cast<Model*>(GetEventSender());
+    auto it = entries_.Find(model);
+    if (it == entries_.End())
+        return;
+
+    // Worker thread may still be reading old geometry data, it is kept alive by the hierarchy.
+    Complete(it->second_);
+    entries_.Erase(it);
+    UnsubscribeFromEvent(model, E_RELOADFINISHED);
+}
+
+}
@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Container/ArrayPtr.h>
+#include <Urho3D/Math/BoundingBox.h>
+#include <Urho3D/Math/Ray.h>
+
+
+namespace Urho3D
+{
+
+class Drawable;
+class Geometry;
+class Model;
+
+/// Bounding volume hierarchy of geometry triangles used for fast ray picking. Triangles are stored in model space.
+class TriangleBVH : public RefCounted
+{
+public:
+    /// Remember geometry data. Data is shared with geometry, so it is safe to call Build() from a worker thread.
+    explicit TriangleBVH(Geometry* geometry);
+    /// Build hierarchy from remembered geometry data and release it.
+    void Build();
+    /// Return distance to the closest triangle hit by ray or M_INFINITY. Back faces are ignored same as in
+    /// Ray::HitDistance().
+    float HitDistance(const Ray& ray) const;
+    /// Return number of triangles.
+    unsigned GetNumTriangles() const { return triangles_.Size() / 3; }
+
+protected:
+    struct BVHNode
+    {
+        /// Bounds of all triangles in this node.
+        BoundingBox bounds_;
+        /// Index of first triangle for leaf nodes, index of left child for inner nodes. Right child follows left one.
+        unsigned first_;
+        /// Number of triangles for leaf nodes, 0 for inner nodes.
+        unsigned count_;
+    };
+
+    /// Split triangles [start, end) of specified node into two children if node has too many triangles.
+    void BuildNode(unsigned nodeIndex, unsigned start, unsigned end, PODVector<unsigned>& order,
+        const PODVector<Vector3>& vertices, const PODVector<Vector3>& centers);
+
+    /// Raw vertex data of geometry. Released after building.
+    SharedArrayPtr<unsigned char> vertexData_;
+    /// Raw index data of geometry. Released after building.
+    SharedArrayPtr<unsigned char> indexData_;
+    /// Size of single vertex.
+    unsigned vertexSize_ = 0;
+    /// Size of single index.
+    unsigned indexSize_ = 0;
+    /// First index or vertex of the geometry.
+    unsigned start_ = 0;
+    /// Number of indices or vertices of the geometry.
+    unsigned count_ = 0;
+    /// Hierarchy nodes. First node is the root.
+    PODVector<BVHNode> nodes_;
+    /// Vertices of triangles ordered by leaf nodes, three per triangle.
+    PODVector<Vector3> triangles_;
+};
+
+/// Cache of triangle hierarchies of models used for editor picking. Hierarchies are built lazily on worker threads
+/// and dropped when model is reloaded or released by resource cache.
+class ModelBVHCache : public Object
+{
+    URHO3D_OBJECT(ModelBVHCache, Object);
+public:
+    /// Construct.
+    explicit ModelBVHCache(Context* context);
+    /// Destruct. Waits for hierarchies being built.
+    ~ModelBVHCache() override;
+    /// Return hierarchy of model geometry at LOD 0. Returns null and starts building it if it is not ready yet.
+    TriangleBVH* GetBVH(Model* model, unsigned geometryIndex);
+    /// Cast ray in world space against drawable. Only static models are supported. Returns false if drawable is not
+    /// supported or its hierarchies are not built yet, caller should fall back to engine raycast then.
+    bool HitDistance(Drawable* drawable, const Ray& ray, float& distance);
+
+protected:
+    struct Entry
+    {
+        /// Model that hierarchies belong to. Used for detecting reuse of address of expired model.
+        WeakPtr<Model> model_;
+        /// Hierarchies of model geometries.
+        Vector<SharedPtr<TriangleBVH>> geometries_;
+        /// Work items building hierarchies.
+        Vector<SharedPtr<WorkItem>> items_;
+    };
+
+    /// Start building hierarchies of all model geometries.
+    Entry& CreateEntry(Model* model);
+    /// Drop hierarchies of models that no longer exist. Does not wait for hierarchies being built.
+    void SweepExpired();
+    /// Wait until hierarchies of entry are built.
+    void Complete(Entry& entry);
+    /// Drop hierarchies of reloaded model.
+    void OnModelReloaded(StringHash eventType, VariantMap& args);
+
+    /// Cached hierarchies mapped by model.
+    HashMap<Model*, Entry> entries_;
+    /// Time since hierarchies of released models were last dropped.
+    Timer sweepTimer_;
+};
+
+}
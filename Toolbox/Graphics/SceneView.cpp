@@ -28,6 +28,7 @@
 #include <Urho3D/Graphics/DebugRenderer.h>
 #include <Urho3D/Graphics/Renderer.h>
 #include <Urho3D/Graphics/RenderPath.h>
+#include <Urho3D/Graphics/RenderSurface.h>
 #include "Scene/DebugCameraController.h"
 
 #include "SceneView.h"
@@ -57,10 +58,57 @@ void SceneView::SetSize(const IntRect& rect)
         return;
 
     rect_ = rect;
-    viewport_->SetRect(IntRect(IntVector2::ZERO, rect.Size()));
+    UpdateViewportRect();
     texture_->SetSize(rect.Width(), rect.Height(), Graphics::GetRGBFormat(), TEXTURE_RENDERTARGET);
     texture_->GetRenderSurface()->SetViewport(0, viewport_);
-    texture_->GetRenderSurface()->SetUpdateMode(SURFACE_UPDATEALWAYS);
+    texture_->GetRenderSurface()->SetUpdateMode(updateMode_);
+    // New texture has no contents, render it at least once.
+    if (updateMode_ == SURFACE_MANUALUPDATE)
+        QueueUpdate();
+}
+
+void SceneView::SetUpdateMode(RenderSurfaceUpdateMode mode)
+{
+    updateMode_ = mode;
+    if (auto surface = texture_->GetRenderSurface())
+        surface->SetUpdateMode(mode);
+}
+
+void SceneView::QueueUpdate()
+{
+    if (auto surface = texture_->GetRenderSurface())
+        surface->QueueUpdate();
+}
+
+void SceneView::SetRenderScale(float scale)
+{
+    scale = Clamp(scale, 0.1f, 1.f);
+    if (scale == renderScale_)
+        return;
+
+    renderScale_ = scale;
+    UpdateViewportRect();
+    if (updateMode_ == SURFACE_MANUALUPDATE)
+        QueueUpdate();
+}
+
+Vector2 SceneView::GetRenderedUV() const
+{
+    if (texture_->GetWidth() == 0 || texture_->GetHeight() == 0)
+        return Vector2::ONE;
+
+    const IntRect& rect = viewport_->GetRect();
+    return {(float)rect.Width() / texture_->GetWidth(), (float)rect.Height() / texture_->GetHeight()};
+}
+
+void SceneView::UpdateViewportRect()
+{
+    // Scene is rendered to top left corner of the texture. Texture itself keeps full size so that changing scale does
+    // not reallocate it.
+    IntVector2 size = rect_.Size();
+    size.x_ = Max(1, (int)(size.x_ * renderScale_));
+    size.y_ = Max(1, (int)(size.y_ * renderScale_));
+    viewport_->SetRect(IntRect(IntVector2::ZERO, size));
 }
 
 void SceneView::CreateObjects()
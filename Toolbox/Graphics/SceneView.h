@@ -24,6 +24,7 @@
 
 
 #include <Urho3D/Core/Object.h>
+#include <Urho3D/Graphics/GraphicsDefs.h>
 
 
 namespace Urho3D
@@ -50,10 +51,26 @@ public:
     Viewport* GetViewport() const { return viewport_; }
     /// Return texture to which view is rendered to.
     Texture2D* GetTexture() const { return texture_; }
+    /// Set when render surface of the view is updated. With SURFACE_MANUALUPDATE view is rendered only on frames when
+    /// QueueUpdate() was called.
+    void SetUpdateMode(RenderSurfaceUpdateMode mode);
+    /// Return when render surface of the view is updated.
+    RenderSurfaceUpdateMode GetUpdateMode() const { return updateMode_; }
+    /// Render view on current frame. Used with SURFACE_MANUALUPDATE update mode.
+    void QueueUpdate();
+    /// Set fraction of view resolution that scene is rendered at. Rendered image is meant to be stretched over the
+    /// whole view, see GetRenderedUV().
+    void SetRenderScale(float scale);
+    /// Return fraction of view resolution that scene is rendered at.
+    float GetRenderScale() const { return renderScale_; }
+    /// Return bottom right texture coordinate of the area scene is rendered to.
+    Vector2 GetRenderedUV() const;
 
 protected:
     /// Creates scene camera and other objects required by editor.
     virtual void CreateObjects();
+    /// Resize viewport according to view size and render scale.
+    void UpdateViewportRect();
 
     /// Rectangle dimensions that are rendered by this view.
     IntRect rect_;
@@ -65,6 +82,10 @@ protected:
     SharedPtr<Viewport> viewport_;
     /// Camera which renders to a texture.
     WeakPtr<Node> camera_;
+    /// Update mode of render surface.
+    RenderSurfaceUpdateMode updateMode_ = SURFACE_UPDATEALWAYS;
+    /// Fraction of view resolution that scene is rendered at.
+    float renderScale_ = 1.f;
 };
 
 }
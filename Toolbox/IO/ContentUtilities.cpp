@@ -111,6 +111,13 @@ ContentType GetContentType(const String& resourcePath)
             return CTYPE_TEXTUREXML;
     }
 
+    if (extension == ".bin")
+    {
+        SharedPtr<File> file(Context::GetContext()->GetCache()->GetFile(resourcePath, false));
+        if (file.NotNull() && file->ReadFileID() == "USCN")
+            return CTYPE_SCENE;
+    }
+
     if (extension == ".mdl")
         return CTYPE_MODEL;
     if (extension == ".ani")
@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneResolver.h>
+#include "NodeClipboard.h"
+#include "Prefab.h"
+
+
+namespace Urho3D
+{
+
+NodeClipboard::NodeClipboard(Context* context)
+    : Object(context)
+{
+}
+
+void NodeClipboard::Copy(const PODVector<Node*>& nodes)
+{
+    Clear();
+    numNodes_ = Serialize(nodes, data_).Size();
+}
+
+void NodeClipboard::Paste(Node* parent, unsigned count, PODVector<Node*>& result) const
+{
+    if (IsEmpty() || parent == nullptr)
+        return;
+
+    PODVector<Node*> parents(numNodes_);
+    for (auto& nodeParent: parents)
+        nodeParent = parent;
+    Instantiate(data_, parents, count, result);
+}
+
+void NodeClipboard::Duplicate(const PODVector<Node*>& nodes, unsigned count, PODVector<Node*>& result) const
+{
+    VectorBuffer buffer;
+    PODVector<Node*> parents = Serialize(nodes, buffer);
+    for (auto& parent: parents)
+        parent = parent->GetParent();
+    Instantiate(buffer, parents, count, result);
+}
+
+void NodeClipboard::Clear()
+{
+    data_.Clear();
+    numNodes_ = 0;
+}
+
+PODVector<Node*> NodeClipboard::Serialize(const PODVector<Node*>& nodes, Serializer& dest)
+{
+    HashSet<Node*> nodeSet;
+    for (Node* node: nodes)
+        nodeSet.Insert(node);
+
+    PODVector<Node*> roots;
+    for (Node* node: nodes)
+    {
+        if (node == nullptr || node->GetParent() == nullptr || node->IsTemporary())
+            continue;
+
+        bool ancestorCopied = false;
+        for (Node* parent = node->GetParent(); parent != nullptr && !ancestorCopied; parent = parent->GetParent())
+            ancestorCopied = nodeSet.Contains(parent);
+        if (ancestorCopied)
+            continue;
+
+        // Node::Save() writes node id first, it is read back by Instantiate() for remapping references.
+        PrefabReference::SetContentTemporary(node, true);
+        dest.WriteBool(node->IsReplicated());
+        node->Save(dest);
+        PrefabReference::SetContentTemporary(node, false);
+        roots.Push(node);
+    }
+    return roots;
+}
+
+void NodeClipboard::Instantiate(const VectorBuffer& source, const PODVector<Node*>& parents, unsigned count,
+    PODVector<Node*>& result)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        // All subtrees of one copy share a resolver, references between them point to nodes of the same copy.
+        SceneResolver resolver;
+        PODVector<Node*> created;
+        MemoryBuffer buffer(source.GetData(), source.GetSize());
+        bool failed = false;
+        for (Node* parent: parents)
+        {
+            CreateMode mode = buffer.ReadBool() ? REPLICATED : LOCAL;
+            unsigned nodeID = buffer.ReadUInt();
+            Node* node = parent->CreateChild(String::EMPTY, mode);
+            resolver.AddNode(nodeID, node);
+            if (!node->Load(buffer, resolver, true, true, mode))
+            {
+                // Rest of the buffer can not be read once a subtree fails to load.
+                URHO3D_LOGERROR("Instantiating copied node failed");
+                node->Remove();
+                failed = true;
+                break;
+            }
+            created.Push(node);
+        }
+
+        resolver.Resolve();
+        for (Node* node: created)
+            node->ApplyAttributes();
+        result.Push(created);
+
+        if (failed)
+            break;
+    }
+}
+
+}
@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+
+namespace Urho3D
+{
+
+class Node;
+
+/// Holds node subtrees serialized in binary format. Pasting instantiates them with new ids, references between copied
+/// nodes and components are remapped to the copies. Clipboard is independent of OS clipboard and may be used for
+/// copying nodes between scenes.
+class NodeClipboard : public Object
+{
+    URHO3D_OBJECT(NodeClipboard, Object);
+public:
+    /// Construct.
+    explicit NodeClipboard(Context* context);
+    /// Copy node subtrees. Nodes whose ancestor is copied as well, temporary nodes and scenes are skipped.
+    void Copy(const PODVector<Node*>& nodes);
+    /// Instantiate copied subtrees count times as children of parent. Created nodes are appended to result.
+    void Paste(Node* parent, unsigned count, PODVector<Node*>& result) const;
+    /// Instantiate node subtrees count times next to original nodes. Created nodes are appended to result. Clipboard
+    /// contents are not changed.
+    void Duplicate(const PODVector<Node*>& nodes, unsigned count, PODVector<Node*>& result) const;
+    /// Clear clipboard.
+    void Clear();
+    /// Return true if clipboard is empty.
+    bool IsEmpty() const { return numNodes_ == 0; }
+    /// Return number of copied subtrees.
+    unsigned GetNumNodes() const { return numNodes_; }
+
+protected:
+    /// Serialize subtrees of nodes that have no ancestors among nodes. Returns root nodes.
+    static PODVector<Node*> Serialize(const PODVector<Node*>& nodes, Serializer& dest);
+    /// Instantiate serialized subtrees count times. Subtree i is added to parents[i].
+    static void Instantiate(const VectorBuffer& source, const PODVector<Node*>& parents, unsigned count,
+        PODVector<Node*>& result);
+
+    /// Serialized node subtrees.
+    VectorBuffer data_;
+    /// Number of serialized subtrees.
+    unsigned numNodes_ = 0;
+};
+
+}
@@ -0,0 +1,212 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Scene/Component.h>
+#include <Urho3D/Scene/SceneEvents.h>
+#include "Common/FuzzyMatch.h"
+#include "NodeSearchIndex.h"
+
+
+namespace Urho3D
+{
+
+NodeSearchIndex::NodeSearchIndex(Context* context)
+    : Object(context)
+{
+}
+
+void NodeSearchIndex::SetScene(Scene* scene)
+{
+    if (!scene_.Expired())
+        UnsubscribeFromAllEvents();
+
+    scene_ = scene;
+    entries_.Clear();
+    componentTypes_.Clear();
+    revision_++;
+
+    if (scene == nullptr)
+        return;
+
+    for (auto& child: scene->GetChildren())
+        AddNode(child);
+
+    SubscribeToEvent(scene, E_NODEADDED, std::bind(&NodeSearchIndex::OnNodeAdded, this, std::placeholders::_2));
+    SubscribeToEvent(scene, E_NODEREMOVED, std::bind(&NodeSearchIndex::OnNodeRemoved, this, std::placeholders::_2));
+    SubscribeToEvent(scene, E_NODENAMECHANGED, std::bind(&NodeSearchIndex::OnNodeNameChanged, this,
+        std::placeholders::_2));
+    for (StringHash eventType: {E_COMPONENTADDED, E_COMPONENTREMOVED})
+    {
+        SubscribeToEvent(scene, eventType, std::bind(&NodeSearchIndex::OnComponentChanged, this,
+            std::placeholders::_1, std::placeholders::_2));
+    }
+}
+
+void NodeSearchIndex::Search(const String& pattern, PODVector<unsigned>& result) const
+{
+    struct Match
+    {
+        unsigned id_;
+        int score_;
+    };
+
+    // Best score of every matching node.
+    HashMap<unsigned, int> scores;
+    int score = 0;
+    for (auto it = entries_.Begin(); it != entries_.End(); it++)
+    {
+        if (FuzzyMatch(pattern, it->second_.name_, &score))
+            scores[it->first_] = score;
+    }
+    for (auto it = componentTypes_.Begin(); it != componentTypes_.End(); it++)
+    {
+        if (!FuzzyMatch(pattern, it->second_.name_, &score))
+            continue;
+
+        const HashMap<unsigned, unsigned>& nodes = it->second_.nodes_;
+        for (auto nodeIt = nodes.Begin(); nodeIt != nodes.End(); nodeIt++)
+        {
+            auto scoreIt = scores.Find(nodeIt->first_);
+            if (scoreIt == scores.End())
+                scores[nodeIt->first_] = score;
+            else
+                scoreIt->second_ = Max(scoreIt->second_, score);
+        }
+    }
+
+    PODVector<Match> matches;
+    matches.Reserve(scores.Size());
+    for (auto it = scores.Begin(); it != scores.End(); it++)
+        matches.Push({it->first_, it->second_});
+
+    Sort(matches.Begin(), matches.End(), [](const Match& a, const Match& b) {
+        return a.score_ > b.score_ || (a.score_ == b.score_ && a.id_ < b.id_);
+    });
+
+    result.Clear();
+    result.Reserve(matches.Size());
+    for (const auto& match: matches)
+        result.Push(match.id_);
+}
+
+void NodeSearchIndex::AddNode(Node* node)
+{
+    // Editor objects are not part of the scene.
+    if (node->IsTemporary())
+        return;
+
+    entries_[node->GetID()].name_ = node->GetName();
+    UpdateComponents(node);
+
+    for (auto& child: node->GetChildren())
+        AddNode(child);
+    revision_++;
+}
+
+void NodeSearchIndex::RemoveNode(Node* node)
+{
+    auto it = entries_.Find(node->GetID());
+    if (it != entries_.End())
+    {
+        RemoveComponents(it->first_, it->second_);
+        entries_.Erase(it);
+    }
+    for (auto& child: node->GetChildren())
+        RemoveNode(child);
+    revision_++;
+}
+
+void NodeSearchIndex::UpdateComponents(Node* node, Component* removed)
+{
+    auto it = entries_.Find(node->GetID());
+    if (it == entries_.End())
+        return;
+
+    RemoveComponents(it->first_, it->second_);
+    PODVector<StringHash>& components = it->second_.components_;
+    components.Clear();
+    for (auto& component: node->GetComponents())
+    {
+        if (component == removed || component->IsTemporary())
+            continue;
+
+        ComponentTypeEntry& type = componentTypes_[component->GetType()];
+        if (type.name_.Empty())
+            type.name_ = component->GetTypeName();
+        type.nodes_[it->first_]++;
+        components.Push(component->GetType());
+    }
+    revision_++;
+}
+
+void NodeSearchIndex::RemoveComponents(unsigned id, const Entry& entry)
+{
+    for (StringHash type: entry.components_)
+    {
+        auto typeIt = componentTypes_.Find(type);
+        if (typeIt == componentTypes_.End())
+            continue;
+
+        HashMap<unsigned, unsigned>& nodes = typeIt->second_.nodes_;
+        auto nodeIt = nodes.Find(id);
+        if (nodeIt != nodes.End() && --nodeIt->second_ == 0)
+            nodes.Erase(nodeIt);
+    }
+}
+
+void NodeSearchIndex::OnNodeAdded(VariantMap& args)
+{
+    using namespace NodeAdded;
+    // Only the topmost node of added subtree is reported.
+    AddNode(static_cast<Node*>(args[P_NODE].GetPtr()));
+}
+
+void NodeSearchIndex::OnNodeRemoved(VariantMap& args)
+{
+    using namespace NodeRemoved;
+    // Event is sent before node is detached, its children are still accessible.
+    RemoveNode(static_cast<Node*>(args[P_NODE].GetPtr()));
+}
+
+void NodeSearchIndex::OnNodeNameChanged(VariantMap& args)
+{
+    using namespace NodeNameChanged;
+    auto* node = static_cast<Node*>(args[P_NODE].GetPtr());
+    auto it = entries_.Find(node->GetID());
+    if (it != entries_.End())
+    {
+        it->second_.name_ = node->GetName();
+        revision_++;
+    }
+}
+
+void NodeSearchIndex::OnComponentChanged(StringHash eventType, VariantMap& args)
+{
+    using namespace ComponentAdded;
+    auto* node = static_cast<Node*>(args[P_NODE].GetPtr());
+    auto* component = static_cast<Component*>(args[P_COMPONENT].GetPtr());
+    // Removed component is still attached to the node when event is sent.
+    UpdateComponents(node, eventType == E_COMPONENTREMOVED ? component : nullptr);
+}
+
+}
@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Scene/Scene.h>
+
+
+namespace Urho3D
+{
+
+/// Index of scene node names and component types used for searching scene hierarchy. Index is built once when scene
+/// is set and is kept up to date incrementally by handling scene change events. Nodes are also indexed by types of
+/// their components, so pattern is matched against every component type once instead of once per node.
+class NodeSearchIndex : public Object
+{
+    URHO3D_OBJECT(NodeSearchIndex, Object);
+public:
+    /// Construct.
+    explicit NodeSearchIndex(Context* context);
+    /// Set scene which is indexed. All existing nodes are indexed immediately.
+    void SetScene(Scene* scene);
+    /// Find nodes whose name or component type names match pattern. Result contains node ids ordered by match score.
+    void Search(const String& pattern, PODVector<unsigned>& result) const;
+    /// Return number of indexed nodes.
+    unsigned GetNumNodes() const { return entries_.Size(); }
+    /// Return revision of index. It changes every time index is modified.
+    unsigned GetRevision() const { return revision_; }
+
+protected:
+    /// Searchable data of a single node.
+    struct Entry
+    {
+        /// Node name.
+        String name_;
+        /// Types of node components.
+        PODVector<StringHash> components_;
+    };
+
+    /// Nodes having components of a single type.
+    struct ComponentTypeEntry
+    {
+        /// Component type name.
+        String name_;
+        /// Number of components of this type mapped by node id.
+        HashMap<unsigned, unsigned> nodes_;
+    };
+
+    /// Add node and all its children to the index.
+    void AddNode(Node* node);
+    /// Remove node and all its children from the index.
+    void RemoveNode(Node* node);
+    /// Update component types of a node. Component which is being removed is skipped.
+    void UpdateComponents(Node* node, Component* removed=nullptr);
+    /// Remove node from component type index.
+    void RemoveComponents(unsigned id, const Entry& entry);
+    /// Handle node being added to the scene.
+    void OnNodeAdded(VariantMap& args);
+    /// Handle node being removed from the scene.
+    void OnNodeRemoved(VariantMap& args);
+    /// Handle node name change.
+    void OnNodeNameChanged(VariantMap& args);
+    /// Handle component being added to or removed from node.
+    void OnComponentChanged(StringHash eventType, VariantMap& args);
+
+    /// Indexed scene.
+    WeakPtr<Scene> scene_;
+    /// Searchable data mapped by node id.
+    HashMap<unsigned, Entry> entries_;
+    /// Ids of nodes mapped by types of their components.
+    HashMap<StringHash, ComponentTypeEntry> componentTypes_;
+    /// Revision of index.
+    unsigned revision_ = 0;
+};
+
+}
@@ -0,0 +1,639 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneResolver.h>
+#include "Prefab.h"
+
+
+namespace Urho3D
+{
+
+PrefabTemplate::PrefabTemplate(Context* context)
+    : scene_(new Scene(context))
+{
+    scene_->SetUpdateEnabled(false);
+}
+
+bool PrefabTemplate::Load(XMLFile* xml)
+{
+    root_ = scene_->CreateChild();
+    if (!root_->LoadXML(xml->GetRoot()))
+        return false;
+
+    // Contents of nested prefab instances are created by their references and are not serialized.
+    PrefabReference::SetContentTemporary(root_, true);
+
+    data_.WriteUInt(root_->GetID());
+    PODVector<Component*> components;
+    for (auto& component: root_->GetComponents())
+    {
+        if (!component->IsTemporary())
+            components.Push(component);
+    }
+    data_.WriteVLE(components.Size());
+    VectorBuffer componentData;
+    for (Component* component: components)
+    {
+        // Components are size-prefixed same as in Node::Save(), unknown component types can be skipped.
+        componentData.Clear();
+        component->Save(componentData);
+        data_.WriteVLE(componentData.GetSize());
+        data_.Write(componentData.GetData(), componentData.GetSize());
+    }
+    PODVector<Node*> children;
+    for (auto& child: root_->GetChildren())
+    {
+        if (!child->IsTemporary())
+            children.Push(child);
+    }
+    data_.WriteVLE(children.Size());
+    for (Node* child: children)
+        child->Save(data_);
+
+    PrefabReference::SetContentTemporary(root_, false);
+
+    for (auto& component: root_->GetComponents())
+        objects_.Push(component);
+    for (auto& child: root_->GetChildren())
+        CollectObjects(child, objects_);
+    return true;
+}
+
+void PrefabTemplate::FindChanges(const PrefabTemplate* previous)
+{
+    previous_ = previous;
+    changes_.Clear();
+    for (unsigned i = 0; i < objects_.Size(); i++)
+    {
+        const Vector<AttributeInfo>* attributes = objects_[i]->GetAttributes();
+        if (attributes == nullptr)
+            continue;
+
+        for (unsigned j = 0; j < attributes->Size(); j++)
+        {
+            if (IsOverridable(attributes->At(j)) &&
+                objects_[i]->GetAttribute(j) != previous->objects_[i]->GetAttribute(j))
+                changes_.Push(MakePair(i, j));
+        }
+    }
+}
+
+bool PrefabTemplate::IsCompatible(const PrefabTemplate* other) const
+{
+    if (other == nullptr || objects_.Size() != other->objects_.Size())
+        return false;
+
+    for (unsigned i = 0; i < objects_.Size(); i++)
+    {
+        if (objects_[i]->GetType() != other->objects_[i]->GetType())
+            return false;
+    }
+    return true;
+}
+
+void PrefabTemplate::CollectObjects(Node* node, PODVector<Serializable*>& objects)
+{
+    if (node->IsTemporary())
+        return;
+
+    objects.Push(node);
+    for (auto& component: node->GetComponents())
+    {
+        if (!component->IsTemporary())
+            objects.Push(component);
+    }
+    for (auto& child: node->GetChildren())
+        CollectObjects(child, objects);
+}
+
+bool PrefabTemplate::IsOverridable(const AttributeInfo& attribute)
+{
+    return (attribute.mode_ & AM_FILE) != 0 && (attribute.mode_ & (AM_NODEID | AM_COMPONENTID | AM_NODEIDVECTOR)) == 0;
+}
+
+PrefabCache::PrefabCache(Context* context)
+    : Object(context)
+{
+}
+
+PrefabTemplate* PrefabCache::GetTemplate(const String& resourceName)
+{
+    auto it = templates_.Find(resourceName);
+    if (it != templates_.End())
+        return it->second_;
+
+    auto* xml = GetSubsystem<ResourceCache>()->GetResource<XMLFile>(resourceName);
+    if (xml == nullptr)
+        return nullptr;
+
+    SharedPtr<PrefabTemplate> prefabTemplate(new PrefabTemplate(context_));
+    if (!prefabTemplate->Load(xml))
+    {
+        URHO3D_LOGERRORF("Loading prefab %s failed", resourceName.CString());
+        return nullptr;
+    }
+
+    templates_[resourceName] = prefabTemplate;
+    SubscribeToEvent(xml, E_RELOADFINISHED, std::bind(&PrefabCache::OnReloadFinished, this, std::placeholders::_1,
+        std::placeholders::_2));
+    return prefabTemplate;
+}
+
+void PrefabCache::OnReloadFinished(StringHash eventType, VariantMap& args)
+{
+    auto* xml = static_cast<XMLFile*>(GetEventSender());
+    auto it = templates_.Find(xml->GetName());
+    if (it == templates_.End())
+        return;
+
+    // Previous template is kept alive by instances until they are updated.
+    SharedPtr<PrefabTemplate> prefabTemplate(new PrefabTemplate(context_));
+    if (!prefabTemplate->Load(xml))
+    {
+        URHO3D_LOGERRORF("Reloading prefab %s failed", xml->GetName().CString());
+        return;
+    }
+    if (prefabTemplate->IsCompatible(it->second_))
+        prefabTemplate->FindChanges(it->second_);
+    it->second_ = prefabTemplate;
+
+    using namespace PrefabChanged;
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_NAME] = xml->GetName();
+    SendEvent(E_PREFABCHANGED, eventData);
+}
+
+PrefabReference::PrefabReference(Context* context)
+    : Component(context)
+{
+}
+
+void PrefabReference::RegisterObject(Context* context)
+{
+    context->RegisterFactory<PrefabReference>();
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Prefab", GetPrefabAttr, SetPrefabAttr, ResourceRef,
+        ResourceRef(XMLFile::GetTypeStatic()), AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Overrides", VariantVector, overrides_, Variant::emptyVariantVector, AM_FILE | AM_NOEDIT);
+    URHO3D_ATTRIBUTE("Additions", VariantVector, additions_, Variant::emptyVariantVector, AM_FILE | AM_NOEDIT);
+}
+
+void PrefabReference::ApplyAttributes()
+{
+    if (dirty_)
+        Instantiate();
+}
+
+void PrefabReference::SetPrefab(const String& resourceName)
+{
+    prefab_ = resourceName;
+    overrides_.Clear();
+    additions_.Clear();
+    Instantiate();
+}
+
+void PrefabReference::SetPrefabAttr(const ResourceRef& value)
+{
+    if (value.name_ == prefab_)
+        return;
+    prefab_ = value.name_;
+    dirty_ = true;
+}
+
+ResourceRef PrefabReference::GetPrefabAttr() const
+{
+    return ResourceRef(XMLFile::GetTypeStatic(), prefab_);
+}
+
+bool PrefabReference::SavePrefab()
+{
+    if (node_ == nullptr || prefab_.Empty())
+        return false;
+
+    auto* cache = GetSubsystem<ResourceCache>();
+    String fileName = cache->GetResourceFileName(prefab_);
+    bool saved = false;
+    if (!fileName.Empty())
+    {
+        // Node keeps its own contents, only nested prefab instances and this reference are left out.
+        SetTemporary(true);
+        for (auto& child: node_->GetChildren())
+            SetContentTemporary(child, true);
+
+        File file(context_, fileName, FILE_WRITE);
+        saved = file.IsOpen() && node_->SaveXML(file);
+
+        for (auto& child: node_->GetChildren())
+            SetContentTemporary(child, false);
+        SetTemporary(false);
+    }
+
+    if (!saved)
+    {
+        URHO3D_LOGERRORF("Saving prefab %s failed", prefab_.CString());
+        return false;
+    }
+
+    // Reloading rebuilds the template and updates every instance without waiting for file watcher.
+    if (auto* xml = cache->GetExistingResource<XMLFile>(prefab_))
+        cache->ReloadResource(xml);
+    return true;
+}
+
+void PrefabReference::SetContentTemporary(Node* root, bool temporary)
+{
+    PODVector<PrefabReference*> prefabs;
+    root->GetComponents<PrefabReference>(prefabs, true);
+    for (PrefabReference* prefab: prefabs)
+    {
+        if (temporary)
+            prefab->UpdateOverrides();
+        for (auto& object: prefab->objects_)
+        {
+            if (!object.Expired())
+                object->SetTemporary(temporary);
+        }
+    }
+
+    // Added objects may contain nested prefab instances, their contents have to be temporary before serializing.
+    if (temporary)
+    {
+        for (PrefabReference* prefab: prefabs)
+            prefab->UpdateAdditions();
+    }
+}
+
+void PrefabReference::Instantiate()
+{
+    dirty_ = false;
+    RemoveContent();
+
+    template_ = prefab_.Empty() ? nullptr : GetPrefabCache()->GetTemplate(prefab_);
+    if (template_.Null() || node_ == nullptr)
+        return;
+
+    // Same as Scene::Instantiate(), except that root components and children are added to existing node.
+    CreateMode mode = IsReplicated() ? REPLICATED : LOCAL;
+    const VectorBuffer& data = template_->GetData();
+    MemoryBuffer source(data.GetData(), data.GetSize());
+    SceneResolver resolver;
+    resolver.AddNode(source.ReadUInt(), node_);
+
+    PODVector<Component*> components;
+    for (unsigned i = 0, count = source.ReadVLE(); i < count && !source.IsEof(); i++)
+    {
+        unsigned size = source.ReadVLE();
+        unsigned end = source.GetPosition() + size;
+        StringHash type = source.ReadStringHash();
+        unsigned id = source.ReadUInt();
+        if (Component* component = node_->CreateComponent(type, mode))
+        {
+            resolver.AddComponent(id, component);
+            component->Load(source);
+            components.Push(component);
+        }
+        source.Seek(end);
+    }
+
+    PODVector<Node*> children;
+    for (unsigned i = 0, count = source.ReadVLE(); i < count && !source.IsEof(); i++)
+    {
+        unsigned id = source.ReadUInt();
+        Node* child = node_->CreateChild(String::EMPTY, mode);
+        resolver.AddNode(id, child);
+        if (!child->Load(source, resolver, true, true, mode))
+        {
+            child->Remove();
+            break;
+        }
+        children.Push(child);
+    }
+
+    resolver.Resolve();
+    for (Component* component: components)
+        component->ApplyAttributes();
+    for (Node* child: children)
+        child->ApplyAttributes();
+
+    // Objects are collected after applying attributes, nested prefab instances have created their contents by now.
+    PODVector<Serializable*> objects;
+    for (Component* component: components)
+        objects.Push(component);
+    for (Node* child: children)
+        PrefabTemplate::CollectObjects(child, objects);
+    for (Serializable* object: objects)
+        objects_.Push(WeakPtr<Serializable>(object));
+
+    if (objects_.Size() != template_->GetObjects().Size())
+    {
+        URHO3D_LOGWARNINGF("Instance of prefab %s does not match the prefab, overrides are not applied",
+            prefab_.CString());
+    }
+    else
+    {
+        ApplyOverrides();
+        ApplyAdditions();
+    }
+}
+
+bool PrefabReference::AdoptPrefab(const String& resourceName)
+{
+    if (node_ == nullptr)
+        return false;
+
+    PrefabTemplate* prefabTemplate = GetPrefabCache()->GetTemplate(resourceName);
+    if (prefabTemplate == nullptr)
+        return false;
+
+    PODVector<Serializable*> objects;
+    for (auto& component: node_->GetComponents())
+    {
+        if (component != this && !component->IsTemporary())
+            objects.Push(component);
+    }
+    for (auto& child: node_->GetChildren())
+        PrefabTemplate::CollectObjects(child, objects);
+
+    const PODVector<Serializable*>& defaults = prefabTemplate->GetObjects();
+    if (objects.Size() != defaults.Size())
+        return false;
+    for (unsigned i = 0; i < objects.Size(); i++)
+    {
+        if (objects[i]->GetType() != defaults[i]->GetType())
+            return false;
+    }
+
+    prefab_ = resourceName;
+    overrides_.Clear();
+    additions_.Clear();
+    dirty_ = false;
+    template_ = prefabTemplate;
+    objects_.Clear();
+    for (Serializable* object: objects)
+        objects_.Push(WeakPtr<Serializable>(object));
+    return true;
+}
+
+PrefabCache* PrefabReference::GetPrefabCache()
+{
+    auto* cache = GetSubsystem<PrefabCache>();
+    if (cache == nullptr)
+    {
+        cache = new PrefabCache(context_);
+        context_->RegisterSubsystem(cache);
+    }
+    SubscribeToEvent(cache, E_PREFABCHANGED, std::bind(&PrefabReference::OnPrefabChanged, this, std::placeholders::_2));
+    return cache;
+}
+
+void PrefabReference::RemoveContent()
+{
+    for (auto& object: objects_)
+    {
+        if (object.Expired())
+            continue;
+        if (auto* node = dynamic_cast<Node*>(object.Get()))
+            node->Remove();
+        else if (auto* component = dynamic_cast<Component*>(object.Get()))
+            component->Remove();
+    }
+    objects_.Clear();
+}
+
+void PrefabReference::UpdateOverrides()
+{
+    if (template_.Null() || objects_.Size() != template_->GetObjects().Size())
+        return;
+
+    overrides_.Clear();
+    const PODVector<Serializable*>& defaults = template_->GetObjects();
+    for (unsigned i = 0; i < objects_.Size(); i++)
+    {
+        Serializable* object = objects_[i];
+        if (object == nullptr)
+        {
+            overrides_.Push((int)i);
+            overrides_.Push(String::EMPTY);
+            overrides_.Push(Variant::EMPTY);
+            continue;
+        }
+
+        const Vector<AttributeInfo>* attributes = object->GetAttributes();
+        if (attributes == nullptr)
+            continue;
+
+        for (unsigned j = 0; j < attributes->Size(); j++)
+        {
+            const AttributeInfo& attribute = attributes->At(j);
+            if (!PrefabTemplate::IsOverridable(attribute))
+                continue;
+
+            Variant value = object->GetAttribute(j);
+            if (value != defaults[i]->GetAttribute(j))
+            {
+                overrides_.Push((int)i);
+                overrides_.Push(attribute.name_);
+                overrides_.Push(value);
+            }
+        }
+    }
+}
+
+void PrefabReference::ApplyOverrides()
+{
+    PODVector<Serializable*> modified;
+    PODVector<unsigned> removed;
+    for (unsigned i = 0; i + 2 < overrides_.Size(); i += 3)
+    {
+        unsigned index = overrides_[i].GetUInt();
+        const String& name = overrides_[i + 1].GetString();
+        if (index >= objects_.Size() || objects_[index].Expired())
+            continue;
+
+        Serializable* object = objects_[index];
+        if (name.Empty())
+            removed.Push(index);
+        else if (object->SetAttribute(name, overrides_[i + 2]) && (modified.Empty() || modified.Back() != object))
+            modified.Push(object);
+    }
+
+    for (Serializable* object: modified)
+        object->ApplyAttributes();
+
+    // Objects are removed last, removing a node destroys objects that may still be in modified list.
+    for (unsigned index: removed)
+    {
+        Serializable* object = objects_[index];
+        if (auto* node = dynamic_cast<Node*>(object))
+            node->Remove();
+        else if (auto* component = dynamic_cast<Component*>(object))
+            component->Remove();
+    }
+}
+
+void PrefabReference::UpdateAdditions()
+{
+    if (template_.Null() || objects_.Size() != template_->GetObjects().Size())
+        return;
+
+    HashSet<Serializable*> content;
+    for (auto& object: objects_)
+    {
+        if (!object.Expired())
+            content.Insert(object.Get());
+    }
+
+    additions_.Clear();
+    VectorBuffer data;
+    for (unsigned i = 0; i < objects_.Size(); i++)
+    {
+        auto* node = dynamic_cast<Node*>(objects_[i].Get());
+        if (node == nullptr)
+            continue;
+
+        for (auto& component: node->GetComponents())
+        {
+            if (component->IsTemporary() || content.Contains(component))
+                continue;
+            data.Clear();
+            component->Save(data);
+            additions_.Push((int)i);
+            additions_.Push(false);
+            additions_.Push(data.GetBuffer());
+        }
+        for (auto& child: node->GetChildren())
+        {
+            if (child->IsTemporary() || content.Contains(child))
+                continue;
+            data.Clear();
+            child->Save(data);
+            additions_.Push((int)i);
+            additions_.Push(true);
+            additions_.Push(data.GetBuffer());
+        }
+    }
+}
+
+void PrefabReference::ApplyAdditions()
+{
+    // Same as loading components and children in Instantiate(). References between added objects are resolved,
+    // references to instantiated objects are not.
+    CreateMode mode = IsReplicated() ? REPLICATED : LOCAL;
+    SceneResolver resolver;
+    PODVector<Serializable*> created;
+    for (unsigned i = 0; i + 2 < additions_.Size(); i += 3)
+    {
+        unsigned index = additions_[i].GetUInt();
+        auto* parent = index < objects_.Size() ? dynamic_cast<Node*>(objects_[index].Get()) : nullptr;
+        if (parent == nullptr)
+        {
+            URHO3D_LOGWARNINGF("Object added to instance of prefab %s was dropped, its parent no longer exists",
+                prefab_.CString());
+            continue;
+        }
+
+        const PODVector<unsigned char>& data = additions_[i + 2].GetBuffer();
+        MemoryBuffer source(data);
+        if (additions_[i + 1].GetBool())
+        {
+            unsigned id = source.ReadUInt();
+            Node* child = parent->CreateChild(String::EMPTY, mode);
+            resolver.AddNode(id, child);
+            if (child->Load(source, resolver, true, true, mode))
+                created.Push(child);
+            else
+                child->Remove();
+        }
+        else
+        {
+            StringHash type = source.ReadStringHash();
+            unsigned id = source.ReadUInt();
+            if (Component* component = parent->CreateComponent(type, mode))
+            {
+                resolver.AddComponent(id, component);
+                if (component->Load(source))
+                    created.Push(component);
+                else
+                    component->Remove();
+            }
+        }
+    }
+
+    resolver.Resolve();
+    for (Serializable* object: created)
+        object->ApplyAttributes();
+}
+
+void PrefabReference::OnPrefabChanged(StringHash eventType, VariantMap& args)
+{
+    using namespace PrefabChanged;
+    if (args[P_NAME].GetString() != prefab_)
+        return;
+
+    PrefabTemplate* current = GetSubsystem<PrefabCache>()->GetTemplate(prefab_);
+    if (current == nullptr || current == template_.Get())
+        return;
+
+    bool aligned = template_.NotNull() && objects_.Size() == template_->GetObjects().Size();
+    if (!aligned || current->GetPrevious() != template_.Get())
+    {
+        // Structure of prefab changed, contents are recreated and overrides and additions are reapplied.
+        if (aligned)
+            SetContentTemporary(node_, true);
+        Instantiate();
+        if (aligned)
+            SetContentTemporary(node_, false);
+        return;
+    }
+
+    // Only attributes that still have values of previous template are updated, overridden ones are kept.
+    const PODVector<Serializable*>& previous = template_->GetObjects();
+    const PODVector<Serializable*>& defaults = current->GetObjects();
+    PODVector<Serializable*> modified;
+    for (const auto& change: current->GetChanges())
+    {
+        Serializable* object = objects_[change.first_];
+        if (object == nullptr)
+            continue;
+        if (object->GetAttribute(change.second_) != previous[change.first_]->GetAttribute(change.second_))
+            continue;
+
+        object->SetAttribute(change.second_, defaults[change.first_]->GetAttribute(change.second_));
+        if (modified.Empty() || modified.Back() != object)
+            modified.Push(object);
+    }
+
+    template_ = current;
+    for (Serializable* object: modified)
+        object->ApplyAttributes();
+}
+
+}
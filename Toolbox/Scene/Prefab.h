@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Scene/Component.h>
+
+
+namespace Urho3D
+{
+
+class Scene;
+class XMLFile;
+
+/// Event sent by PrefabCache when prefab resource was reloaded and its template was rebuilt.
+URHO3D_EVENT(E_PREFABCHANGED, PrefabChanged)
+{
+    URHO3D_PARAM(P_NAME, Name);                       // String, resource name of prefab.
+}
+
+/// Prefab contents loaded once and shared by all instances of the prefab. Objects of a template are its root
+/// components followed by every child node, its components and children in depth-first order.
+class PrefabTemplate : public RefCounted
+{
+public:
+    /// Construct.
+    explicit PrefabTemplate(Context* context);
+    /// Load template from xml file containing serialized node.
+    bool Load(XMLFile* xml);
+    /// Remember attributes which differ from previous template of the same prefab. Templates must be compatible.
+    void FindChanges(const PrefabTemplate* previous);
+    /// Return true if both templates consist of the same object types in the same order.
+    bool IsCompatible(const PrefabTemplate* other) const;
+    /// Return template objects.
+    const PODVector<Serializable*>& GetObjects() const { return objects_; }
+    /// Return template contents serialized in binary format.
+    const VectorBuffer& GetData() const { return data_; }
+    /// Return template that changes were found against.
+    const PrefabTemplate* GetPrevious() const { return previous_; }
+    /// Return object and attribute indices of attributes that differ from previous template.
+    const PODVector<Pair<unsigned, unsigned>>& GetChanges() const { return changes_; }
+
+    /// Append node, its components and children to a list of objects in template order.
+    static void CollectObjects(Node* node, PODVector<Serializable*>& objects);
+    /// Return true if attribute may be overridden by prefab instances. Node and component id references are resolved
+    /// on instantiation and are never overridden.
+    static bool IsOverridable(const AttributeInfo& attribute);
+
+protected:
+    /// Scene which owns template nodes. It is never updated.
+    SharedPtr<Scene> scene_;
+    /// Root node of the prefab.
+    Node* root_ = nullptr;
+    /// Template objects.
+    PODVector<Serializable*> objects_;
+    /// Serialized root id, root components and child nodes.
+    VectorBuffer data_;
+    /// Template that changes were found against. Used only for identity comparison.
+    const PrefabTemplate* previous_ = nullptr;
+    /// Object and attribute indices of changed attributes.
+    PODVector<Pair<unsigned, unsigned>> changes_;
+};
+
+/// Loads prefab templates and rebuilds them when prefab resources are reloaded.
+class PrefabCache : public Object
+{
+    URHO3D_OBJECT(PrefabCache, Object);
+public:
+    /// Construct.
+    explicit PrefabCache(Context* context);
+    /// Return template of prefab resource, loading it if necessary. Returns null if prefab can not be loaded.
+    PrefabTemplate* GetTemplate(const String& resourceName);
+
+protected:
+    /// Rebuild template of reloaded prefab and notify instances.
+    void OnReloadFinished(StringHash eventType, VariantMap& args);
+
+    /// Loaded templates mapped by prefab resource name.
+    HashMap<String, SharedPtr<PrefabTemplate>> templates_;
+};
+
+/// Makes contents of a node an instance of prefab. Components and children of the prefab root are created on the
+/// node. Only attributes that differ from the prefab and components and nodes added to instantiated nodes are saved.
+/// Attributes that were not overridden are updated when prefab changes.
+class PrefabReference : public Component
+{
+    URHO3D_OBJECT(PrefabReference, Component);
+public:
+    /// Construct.
+    explicit PrefabReference(Context* context);
+    /// Register object factory and attributes.
+    static void RegisterObject(Context* context);
+    /// Instantiate prefab if it was changed by attributes.
+    void ApplyAttributes() override;
+
+    /// Set prefab resource and instantiate it.
+    void SetPrefab(const String& resourceName);
+    /// Set prefab resource and make current components and children of the node its instance instead of
+    /// instantiating the prefab. Existing objects keep their ids. Returns false and leaves node unchanged if contents
+    /// do not match the prefab.
+    bool AdoptPrefab(const String& resourceName);
+    /// Return prefab resource name.
+    const String& GetPrefab() const { return prefab_; }
+    /// Save current contents of the node as the prefab and reload it, which updates all other instances. This
+    /// component is not saved.
+    bool SavePrefab();
+    /// Record attributes of instantiated objects that differ from the prefab.
+    void UpdateOverrides();
+    /// Serialize components and child nodes that were added to instantiated nodes. Instantiated contents of this and
+    /// nested prefab instances must be temporary, so that they are not serialized together with added nodes.
+    void UpdateAdditions();
+    /// Set prefab attribute.
+    void SetPrefabAttr(const ResourceRef& value);
+    /// Return prefab attribute.
+    ResourceRef GetPrefabAttr() const;
+
+    /// Update overrides and additions of all prefab instances in a subtree and mark their instantiated contents
+    /// temporary, so that saving the subtree stores only prefab references, overrides and additions. Call again with
+    /// false once saving is done.
+    static void SetContentTemporary(Node* root, bool temporary);
+
+protected:
+    /// Remove previously instantiated objects and instantiate prefab.
+    void Instantiate();
+    /// Return prefab cache, creating it if necessary, and subscribe to changes of prefabs.
+    PrefabCache* GetPrefabCache();
+    /// Remove objects created by Instantiate().
+    void RemoveContent();
+    /// Apply recorded overrides to instantiated objects.
+    void ApplyOverrides();
+    /// Recreate components and nodes that were added to instantiated nodes.
+    void ApplyAdditions();
+    /// Update instance attributes which were not overridden when prefab changes.
+    void OnPrefabChanged(StringHash eventType, VariantMap& args);
+
+    /// Prefab resource name.
+    String prefab_;
+    /// Overridden attributes stored as triplets of object index, attribute name and value. Empty attribute name means
+    /// that object was removed.
+    VariantVector overrides_;
+    /// Added objects stored as triplets of index of instantiated node they were added to, flag which is true for nodes
+    /// and false for components, and serialized object.
+    VariantVector additions_;
+    /// Template this instance was created from.
+    SharedPtr<PrefabTemplate> template_;
+    /// Instantiated objects, matching template objects by index.
+    Vector<WeakPtr<Serializable>> objects_;
+    /// Flag indicating that prefab has to be instantiated in ApplyAttributes().
+    bool dirty_ = false;
+};
+
+}
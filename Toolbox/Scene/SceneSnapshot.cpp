@@ -0,0 +1,208 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Scene/Component.h>
+#include <Urho3D/Scene/Scene.h>
+#include <cstring>
+#include "SceneSnapshot.h"
+
+
+namespace Urho3D
+{
+
+void SceneSnapshot::Save(Scene* scene)
+{
+    Clear();
+    SaveNode(scene, 0);
+}
+
+void SceneSnapshot::SaveNode(Node* node, unsigned parentID)
+{
+    if (node->IsTemporary())
+        return;
+
+    NodeState nodeState;
+    nodeState.id_ = node->GetID();
+    nodeState.parentID_ = parentID;
+    nodeState.offset_ = data_.GetPosition();
+    nodeState.size_ = SaveAttributes(node);
+    nodes_.Push(nodeState);
+
+    for (auto& component: node->GetComponents())
+    {
+        if (component->IsTemporary())
+            continue;
+
+        ComponentState componentState;
+        componentState.id_ = component->GetID();
+        componentState.nodeID_ = node->GetID();
+        componentState.type_ = component->GetType();
+        componentState.offset_ = data_.GetPosition();
+        componentState.size_ = SaveAttributes(component);
+        components_.Push(componentState);
+    }
+
+    for (auto& child: node->GetChildren())
+        SaveNode(child, node->GetID());
+}
+
+unsigned SceneSnapshot::SaveAttributes(Serializable* item)
+{
+    // Node::Save() would also write components and children, only attributes of the object itself are stored.
+    unsigned start = data_.GetPosition();
+    item->Serializable::Save(data_);
+    return data_.GetPosition() - start;
+}
+
+bool SceneSnapshot::IsChanged(Serializable* item, unsigned offset, unsigned size)
+{
+    current_.Clear();
+    item->Serializable::Save(current_);
+    return current_.GetSize() != size || memcmp(current_.GetData(), data_.GetData() + offset, size) != 0;
+}
+
+void SceneSnapshot::LoadAttributes(Serializable* item, unsigned offset, unsigned size)
+{
+    MemoryBuffer source(data_.GetData() + offset, size);
+    item->Serializable::Load(source);
+}
+
+unsigned SceneSnapshot::Restore(Scene* scene)
+{
+    if (IsEmpty())
+        return 0;
+
+    unsigned changes = 0;
+    HashSet<unsigned> nodeIDs;
+    HashSet<unsigned> componentIDs;
+    for (const NodeState& state: nodes_)
+        nodeIDs.Insert(state.id_);
+    for (const ComponentState& state: components_)
+        componentIDs.Insert(state.id_);
+
+    // Remove objects created after snapshot was taken. Objects are looked up by id when removing, because removing
+    // a node also removes its children and components.
+    PODVector<Node*> nodes;
+    scene->GetChildren(nodes, true);
+    nodes.Push(scene);
+    PODVector<unsigned> removedNodes;
+    PODVector<unsigned> removedComponents;
+    for (Node* node: nodes)
+    {
+        if (node->IsTemporary())
+            continue;
+        if (!nodeIDs.Contains(node->GetID()))
+            removedNodes.Push(node->GetID());
+        for (auto& component: node->GetComponents())
+        {
+            if (!component->IsTemporary() && !componentIDs.Contains(component->GetID()))
+                removedComponents.Push(component->GetID());
+        }
+    }
+    for (unsigned id: removedNodes)
+    {
+        if (Node* node = scene->GetNode(id))
+        {
+            node->Remove();
+            changes++;
+        }
+    }
+    for (unsigned id: removedComponents)
+    {
+        if (Component* component = scene->GetComponent(id))
+        {
+            component->Remove();
+            changes++;
+        }
+    }
+
+    // Parents precede children in the snapshot, so every node is attached to a parent that is already restored.
+    PODVector<Serializable*> loaded;
+    for (const NodeState& state: nodes_)
+    {
+        Node* node = state.parentID_ == 0 ? scene : scene->GetNode(state.id_);
+        Node* parent = state.parentID_ == 0 ? nullptr : scene->GetNode(state.parentID_);
+        bool created = false;
+        if (node == nullptr)
+        {
+            if (parent == nullptr)
+                continue;
+            node = parent->CreateChild(String::EMPTY, state.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL, state.id_);
+            created = true;
+        }
+        else if (parent != nullptr && node->GetParent() != parent)
+        {
+            node->SetParent(parent);
+            changes++;
+        }
+
+        if (created || IsChanged(node, state.offset_, state.size_))
+        {
+            LoadAttributes(node, state.offset_, state.size_);
+            loaded.Push(node);
+            changes++;
+        }
+    }
+
+    for (const ComponentState& state: components_)
+    {
+        Node* node = scene->GetNode(state.nodeID_);
+        Component* component = scene->GetComponent(state.id_);
+        if (node == nullptr)
+            continue;
+
+        bool created = false;
+        if (component == nullptr)
+        {
+            component = node->CreateComponent(state.type_, state.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL, state.id_);
+            if (component == nullptr)
+                continue;
+            created = true;
+        }
+
+        if (created || IsChanged(component, state.offset_, state.size_))
+        {
+            LoadAttributes(component, state.offset_, state.size_);
+            loaded.Push(component);
+            changes++;
+        }
+    }
+
+    // Attributes are applied once everything is loaded, so that references between nodes and components resolve.
+    for (Serializable* item: loaded)
+        item->ApplyAttributes();
+
+    current_.Clear();
+    return changes;
+}
+
+void SceneSnapshot::Clear()
+{
+    data_.Clear();
+    nodes_.Clear();
+    components_.Clear();
+}
+
+}
@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/StringHash.h>
+
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+class Serializable;
+
+/// In-memory binary snapshot of scene contents which is restored in place. Attributes of every node and component are
+/// stored separately, so restoring compares them with the current scene and loads only objects that changed. Objects
+/// created after the snapshot are removed and removed objects are recreated with their original ids. Temporary nodes
+/// and components are ignored.
+class SceneSnapshot
+{
+public:
+    /// Take snapshot of the scene.
+    void Save(Scene* scene);
+    /// Restore scene to the state of the snapshot. Returns number of nodes and components that were changed, created
+    /// or removed. Recreated nodes are appended to their parents, order of siblings is not restored.
+    unsigned Restore(Scene* scene);
+    /// Release snapshot data.
+    void Clear();
+    /// Return true if snapshot was not taken.
+    bool IsEmpty() const { return nodes_.Empty(); }
+    /// Return size of snapshot data in bytes.
+    unsigned GetSize() const { return data_.GetSize(); }
+
+protected:
+    /// Snapshot of node attributes.
+    struct NodeState
+    {
+        /// Node id.
+        unsigned id_;
+        /// Id of parent node, 0 for scene.
+        unsigned parentID_;
+        /// Offset of serialized attributes in data_.
+        unsigned offset_;
+        /// Size of serialized attributes.
+        unsigned size_;
+    };
+    /// Snapshot of component attributes.
+    struct ComponentState
+    {
+        /// Component id.
+        unsigned id_;
+        /// Id of node which owns the component.
+        unsigned nodeID_;
+        /// Component type.
+        StringHash type_;
+        /// Offset of serialized attributes in data_.
+        unsigned offset_;
+        /// Size of serialized attributes.
+        unsigned size_;
+    };
+
+    /// Save attributes of node, its components and children.
+    void SaveNode(Node* node, unsigned parentID);
+    /// Serialize attributes of an object to data_. Returns size of serialized data.
+    unsigned SaveAttributes(Serializable* item);
+    /// Return true if current attributes of an object differ from the snapshot.
+    bool IsChanged(Serializable* item, unsigned offset, unsigned size);
+    /// Load attributes of an object from the snapshot. ApplyAttributes() is not called.
+    void LoadAttributes(Serializable* item, unsigned offset, unsigned size);
+
+    /// Serialized attributes of all nodes and components.
+    VectorBuffer data_;
+    /// Node snapshots, parents precede their children.
+    PODVector<NodeState> nodes_;
+    /// Component snapshots.
+    PODVector<ComponentState> components_;
+    /// Scratch buffer for serializing current attributes.
+    VectorBuffer current_;
+};
+
+}
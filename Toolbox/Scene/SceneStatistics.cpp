@@ -0,0 +1,298 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/OctreeQuery.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/SceneEvents.h>
+#include "SystemUI/SystemUI.h"
+#include "SceneStatistics.h"
+
+
+namespace Urho3D
+{
+
+/// Interval in milliseconds between sampling octree and resource statistics.
+static const unsigned statisticsSampleIntervalMs = 1000;
+/// Number of largest resources that are listed.
+static const unsigned numLargestResources = 10;
+
+SceneStatistics::SceneStatistics(Context* context)
+    : Object(context)
+{
+}
+
+void SceneStatistics::SetScene(Scene* scene)
+{
+    if (!scene_.Expired())
+        UnsubscribeFromAllEvents();
+
+    scene_ = scene;
+    numNodes_ = 0;
+    numComponents_ = 0;
+    numDrawables_ = 0;
+    numLights_ = 0;
+    components_.Clear();
+    sampled_ = false;
+
+    if (scene == nullptr)
+        return;
+
+    // Scene itself is not counted as a node, but its components are.
+    for (auto& component: scene->GetComponents())
+        AddComponent(component, 1);
+    for (auto& child: scene->GetChildren())
+        AddNode(child, 1);
+
+    for (StringHash eventType: {E_NODEADDED, E_NODEREMOVED})
+    {
+        SubscribeToEvent(scene, eventType, std::bind(&SceneStatistics::OnNodeChanged, this, std::placeholders::_1,
+            std::placeholders::_2));
+    }
+    for (StringHash eventType: {E_COMPONENTADDED, E_COMPONENTREMOVED})
+    {
+        SubscribeToEvent(scene, eventType, std::bind(&SceneStatistics::OnComponentChanged, this,
+            std::placeholders::_1, std::placeholders::_2));
+    }
+}
+
+void SceneStatistics::AddNode(Node* node, int sign)
+{
+    // Editor objects are not part of the scene.
+    if (node->IsTemporary())
+        return;
+
+    numNodes_ += sign;
+    for (auto& component: node->GetComponents())
+        AddComponent(component, sign);
+    for (auto& child: node->GetChildren())
+        AddNode(child, sign);
+}
+
+void SceneStatistics::AddComponent(Component* component, int sign)
+{
+    if (component->IsTemporary())
+        return;
+
+    auto it = components_.Find(component->GetType());
+    if (it == components_.End())
+    {
+        if (sign < 0)
+            return;
+
+        ComponentStats stats;
+        stats.typeName_ = component->GetTypeName();
+        stats.isLight_ = dynamic_cast<Light*>(component) != nullptr;
+        stats.isDrawable_ = stats.isLight_ || dynamic_cast<Drawable*>(component) != nullptr;
+        it = components_.Insert(MakePair(component->GetType(), stats));
+    }
+
+    ComponentStats& stats = it->second_;
+    stats.count_ += sign;
+    if (stats.sample_.Expired() && sign > 0)
+        stats.sample_ = component;
+    numComponents_ += sign;
+    if (stats.isDrawable_)
+        numDrawables_ += sign;
+    if (stats.isLight_)
+        numLights_ += sign;
+
+    if (stats.count_ == 0)
+        components_.Erase(it);
+}
+
+void SceneStatistics::Sample()
+{
+    sampleTimer_.Reset();
+    sampled_ = true;
+
+    // Components are measured only once they are loaded, measuring on creation would report default values.
+    for (auto it = components_.Begin(); it != components_.End(); it++)
+    {
+        ComponentStats& stats = it->second_;
+        if (stats.size_ == 0 && !stats.sample_.Expired())
+        {
+            VectorBuffer buffer;
+            stats.sample_->Save(buffer);
+            stats.size_ = buffer.GetSize();
+        }
+    }
+
+    octreeLevels_ = 0;
+    occupiedOctants_ = 0;
+    octreeLevelDrawables_.Clear();
+    if (auto* octree = scene_->GetComponent<Octree>())
+    {
+        octreeLevels_ = octree->GetNumLevels();
+        octreeLevelDrawables_.Resize(octreeLevels_ + 1);
+        for (auto& count: octreeLevelDrawables_)
+            count = 0;
+
+        PODVector<Drawable*> drawables;
+        AllContentOctreeQuery query(drawables, DRAWABLE_ANY);
+        octree->GetDrawables(query);
+
+        HashSet<Octant*> octants;
+        for (Drawable* drawable: drawables)
+        {
+            Octant* octant = drawable->GetOctant();
+            if (octant == nullptr)
+                continue;
+            octants.Insert(octant);
+            unsigned level = Min(octant->GetLevel(), octreeLevels_);
+            octreeLevelDrawables_[level]++;
+        }
+        occupiedOctants_ = octants.Size();
+    }
+
+    resources_.Clear();
+    largestResources_.Clear();
+    PODVector<Resource*> allResources;
+    const auto& groups = GetSubsystem<ResourceCache>()->GetAllResources();
+    for (auto it = groups.Begin(); it != groups.End(); it++)
+    {
+        const ResourceGroup& group = it->second_;
+        if (group.resources_.Empty())
+            continue;
+
+        ResourceStats stats;
+        stats.typeName_ = group.resources_.Front().second_->GetTypeName();
+        stats.count_ = group.resources_.Size();
+        stats.memoryUse_ = group.memoryUse_;
+        resources_.Push(stats);
+
+        for (auto jt = group.resources_.Begin(); jt != group.resources_.End(); jt++)
+            allResources.Push(jt->second_);
+    }
+    Sort(resources_.Begin(), resources_.End(), [](const ResourceStats& a, const ResourceStats& b) {
+        return a.memoryUse_ > b.memoryUse_;
+    });
+
+    Sort(allResources.Begin(), allResources.End(), [](Resource* a, Resource* b) {
+        return a->GetMemoryUse() > b->GetMemoryUse();
+    });
+    for (unsigned i = 0; i < Min(allResources.Size(), numLargestResources); i++)
+        largestResources_.Push(MakePair(allResources[i]->GetName(), allResources[i]->GetMemoryUse()));
+}
+
+void SceneStatistics::RenderUI()
+{
+    if (scene_.Expired())
+        return;
+
+    if (!sampled_ || sampleTimer_.GetMSec(false) >= statisticsSampleIntervalMs)
+        Sample();
+
+    ui::Text("Nodes: %u", numNodes_);
+    ui::Text("Components: %u", numComponents_);
+    ui::Text("Drawables: %u", numDrawables_);
+    ui::Text("Lights: %u", numLights_);
+
+    if (ui::CollapsingHeader("Components", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        PODVector<const ComponentStats*> sorted;
+        for (auto it = components_.Begin(); it != components_.End(); it++)
+            sorted.Push(&it->second_);
+        Sort(sorted.Begin(), sorted.End(), [](const ComponentStats* a, const ComponentStats* b) {
+            return a->count_ > b->count_;
+        });
+
+        ui::Columns(3, "Components");
+        ui::TextUnformatted("Type");
+        ui::NextColumn();
+        ui::TextUnformatted("Count");
+        ui::NextColumn();
+        ui::TextUnformatted("Est. memory");
+        ui::NextColumn();
+        ui::Separator();
+        for (const auto* stats: sorted)
+        {
+            ui::TextUnformatted(stats->typeName_.CString());
+            ui::NextColumn();
+            ui::Text("%u", stats->count_);
+            ui::NextColumn();
+            ui::TextUnformatted(GetFileSizeString((unsigned long long)stats->size_ * stats->count_).CString());
+            ui::NextColumn();
+        }
+        ui::Columns(1);
+    }
+
+    if (ui::CollapsingHeader("Octree"))
+    {
+        ui::Text("Levels: %u", octreeLevels_);
+        ui::Text("Occupied octants: %u", occupiedOctants_);
+        for (unsigned i = 0; i < octreeLevelDrawables_.Size(); i++)
+        {
+            if (octreeLevelDrawables_[i] > 0)
+                ui::Text("Level %u: %u drawables", i, octreeLevelDrawables_[i]);
+        }
+    }
+
+    if (ui::CollapsingHeader("Resources"))
+    {
+        ui::Columns(3, "Resources");
+        ui::TextUnformatted("Type");
+        ui::NextColumn();
+        ui::TextUnformatted("Count");
+        ui::NextColumn();
+        ui::TextUnformatted("Memory");
+        ui::NextColumn();
+        ui::Separator();
+        for (const auto& stats: resources_)
+        {
+            ui::TextUnformatted(stats.typeName_.CString());
+            ui::NextColumn();
+            ui::Text("%u", stats.count_);
+            ui::NextColumn();
+            ui::TextUnformatted(GetFileSizeString(stats.memoryUse_).CString());
+            ui::NextColumn();
+        }
+        ui::Columns(1);
+
+        ui::Separator();
+        ui::TextUnformatted("Largest resources");
+        for (const auto& resource: largestResources_)
+            ui::Text("%s: %s", resource.first_.CString(), GetFileSizeString(resource.second_).CString());
+    }
+}
+
+void SceneStatistics::OnNodeChanged(StringHash eventType, VariantMap& args)
+{
+    using namespace NodeAdded;
+    // Only the topmost node of added or removed subtree is reported. Removed node still has its children.
+    AddNode(static_cast<Node*>(args[P_NODE].GetPtr()), eventType == E_NODEADDED ? 1 : -1);
+}
+
+void SceneStatistics::OnComponentChanged(StringHash eventType, VariantMap& args)
+{
+    using namespace ComponentAdded;
+    auto* node = static_cast<Node*>(args[P_NODE].GetPtr());
+    if (node->IsTemporary())
+        return;
+    AddComponent(static_cast<Component*>(args[P_COMPONENT].GetPtr()), eventType == E_COMPONENTADDED ? 1 : -1);
+}
+
+}
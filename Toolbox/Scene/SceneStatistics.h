@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Scene/Scene.h>
+
+
+namespace Urho3D
+{
+
+/// Collects statistics of scene contents, octree and loaded resources. Node and component counts are built once when
+/// scene is set and are kept up to date incrementally by handling scene change events. Octree and resource statistics
+/// are sampled periodically while statistics are rendered.
+class SceneStatistics : public Object
+{
+    URHO3D_OBJECT(SceneStatistics, Object);
+public:
+    /// Construct.
+    explicit SceneStatistics(Context* context);
+    /// Set scene statistics are collected for.
+    void SetScene(Scene* scene);
+    /// Render statistics ui. This needs to be called between ui::Begin() / ui::End().
+    void RenderUI();
+    /// Return number of nodes in the scene.
+    unsigned GetNumNodes() const { return numNodes_; }
+    /// Return number of components in the scene.
+    unsigned GetNumComponents() const { return numComponents_; }
+
+protected:
+    /// Statistics of one component type.
+    struct ComponentStats
+    {
+        /// Name of component type.
+        String typeName_;
+        /// Number of components of this type.
+        unsigned count_ = 0;
+        /// Estimated size of single component. Measured as serialized size of the first component of this type.
+        unsigned size_ = 0;
+        /// Flag indicating that components of this type are drawables.
+        bool isDrawable_ = false;
+        /// Flag indicating that components of this type are lights.
+        bool isLight_ = false;
+        /// Component which size is measured.
+        WeakPtr<Component> sample_;
+    };
+    /// Statistics of one resource type.
+    struct ResourceStats
+    {
+        /// Name of resource type.
+        String typeName_;
+        /// Number of loaded resources.
+        unsigned count_ = 0;
+        /// Memory used by resources of this type.
+        unsigned long long memoryUse_ = 0;
+    };
+
+    /// Count node, its components and children.
+    void AddNode(Node* node, int sign);
+    /// Count component.
+    void AddComponent(Component* component, int sign);
+    /// Sample octree and resource statistics.
+    void Sample();
+    /// Handle node being added to or removed from the scene.
+    void OnNodeChanged(StringHash eventType, VariantMap& args);
+    /// Handle component being added to or removed from node.
+    void OnComponentChanged(StringHash eventType, VariantMap& args);
+
+    /// Scene statistics are collected for.
+    WeakPtr<Scene> scene_;
+    /// Number of nodes.
+    unsigned numNodes_ = 0;
+    /// Number of components.
+    unsigned numComponents_ = 0;
+    /// Number of drawables.
+    unsigned numDrawables_ = 0;
+    /// Number of lights.
+    unsigned numLights_ = 0;
+    /// Component statistics mapped by component type.
+    HashMap<StringHash, ComponentStats> components_;
+    /// Number of octree levels.
+    unsigned octreeLevels_ = 0;
+    /// Number of drawables at each octree level.
+    PODVector<unsigned> octreeLevelDrawables_;
+    /// Number of octants that contain drawables.
+    unsigned occupiedOctants_ = 0;
+    /// Resource statistics mapped by resource type.
+    Vector<ResourceStats> resources_;
+    /// Names and memory use of largest resources.
+    Vector<Pair<String, unsigned long long>> largestResources_;
+    /// Time since octree and resource statistics were sampled.
+    Timer sampleTimer_;
+    /// Flag indicating that octree and resource statistics were never sampled.
+    bool sampled_ = false;
+};
+
+}
@@ -36,6 +36,7 @@
 #include <Urho3D/Graphics/Renderer.h>
 #include <Urho3D/Graphics/RenderPath.h>
 #include "AttributeInspector.h"
+#include "Common/FuzzyMatch.h"
 #include "ImGuiDock.h"
 #include "Widgets.h"
 
@@ -68,6 +69,10 @@ static const char* fillModeNames[] =
 #define MAX_FILLMODES (IM_ARRAYSIZE(fillModeNames) - 1)
 
 const float attributeIndentLevel = 15.f;
+/// Max size of text attribute values, including null terminator.
+const unsigned attributeBufferMaxSize = 0x1000;
+/// Max number of array attribute elements rendered at once.
+const unsigned attributeArrayPageSize = 32;
 
 /// Renders material preview in attribute inspector.
 class MaterialView : public SceneView
@@ -191,15 +196,75 @@ protected:
     float distance_ = 1.5f;
 };
 
+/// Text buffer of string attribute widgets. Idle buffers are only as big as text they hold, memory comes from pooled ui
+/// state allocator. Buffer grows to max size only when it may be edited.
 struct AttributeInspectorBuffer
 {
     explicit AttributeInspectorBuffer(const String& defaultValue=String::EMPTY)
     {
-        strncpy(buffer_, defaultValue.CString(), sizeof(buffer_) - 1);
-        buffer_[sizeof(buffer_) - 1] = 0;
+        Reserve(defaultValue.Length() + 1);
+        strncpy(buffer_, defaultValue.CString(), capacity_ - 1);
+        buffer_[capacity_ - 1] = 0;
     }
 
-    char buffer_[0x1000]{};
+    AttributeInspectorBuffer(const AttributeInspectorBuffer&) = delete;
+    AttributeInspectorBuffer& operator=(const AttributeInspectorBuffer&) = delete;
+
+    ~AttributeInspectorBuffer()
+    {
+        if (buffer_ != inline_)
+            ui::FreeUIStateMemory(buffer_, capacity_);
+    }
+
+    /// Resize buffer to the size class that fits specified number of bytes. Text is truncated if it does not fit.
+    void Reserve(unsigned size)
+    {
+        size = Min(size, attributeBufferMaxSize);
+        unsigned capacity = size <= sizeof(inline_) ? sizeof(inline_) : NextPowerOfTwo(size);
+        if (capacity == capacity_)
+            return;
+
+        char* buffer = capacity == sizeof(inline_) ? inline_ : (char*)ui::AllocateUIStateMemory(capacity);
+        strncpy(buffer, buffer_, capacity - 1);
+        buffer[capacity - 1] = 0;
+        if (buffer_ != inline_)
+            ui::FreeUIStateMemory(buffer_, capacity_);
+        buffer_ = buffer;
+        capacity_ = capacity;
+    }
+
+    /// Shrink buffer to the smallest size class that fits current text.
+    void Shrink()
+    {
+        if (buffer_ != inline_)
+            Reserve(strlen(buffer_) + 1);
+    }
+
+    /// Text input widget for this buffer. Text input captures buffer size when editing starts, therefore buffer is
+    /// expanded to max size while widget is hovered or active.
+    bool InputText(ImGuiInputTextFlags flags=0)
+    {
+        auto& g = *ui::GetCurrentContext();
+        ImGuiID id = ui::GetCurrentWindow()->GetID("");
+        if (g.ActiveId == id || g.HoveredId == id || g.HoveredIdPreviousFrame == id)
+            Reserve(attributeBufferMaxSize);
+        else
+            Shrink();
+        return ui::InputText("", buffer_, capacity_, flags);
+    }
+
+    /// Current text buffer, either inline storage or pooled memory.
+    char* buffer_ = inline_;
+    /// Size of current text buffer.
+    unsigned capacity_ = sizeof(inline_);
+    /// Storage for short strings.
+    char inline_[20]{};
+};
+
+struct AttributeInspectorArrayPage
+{
+    /// Index of currently displayed page of array elements.
+    unsigned page_ = 0;
 };
 
 AttributeInspector::AttributeInspector(Urho3D::Context* context)
@@ -238,23 +303,20 @@ void AttributeInspector::RenderAttributes(const PODVector<Serializable*>& items)
             const char* modifiedThisFrame = nullptr;
             const auto& attributes = *item->GetAttributes();
 
-            for (const AttributeInfo& info: attributes)
+            for (unsigned index: GetFilteredAttributes(item))
             {
+                const AttributeInfo& info = attributes[index];
                 bool hidden = false;
                 Color color = Color::WHITE;
                 String tooltip;
 
-                Variant value, oldValue;
-                value = oldValue = item->GetAttribute(info.name_);
+                // Value is copied once per frame. Widgets edit it in place, array attributes modify only changed
+                // elements.
+                Variant value = item->GetAttribute(info.name_);
 
                 if (value == info.defaultValue_)
                     color = Color::GRAY;
 
-                if (info.mode_ & AM_NOEDIT)
-                    hidden = true;
-                else if (filter_.front() && !info.name_.Contains(&filter_.front(), false))
-                    hidden = true;
-
                 // Customize attribute rendering
                 {
                     using namespace AttributeInspectorAttribute;
@@ -289,9 +351,8 @@ void AttributeInspector::RenderAttributes(const PODVector<Serializable*>& items)
                     {
                         if (ui::MenuItem("Reset to default"))
                         {
-                            item->SetAttribute(info.name_, info.defaultValue_);
-                            item->ApplyAttributes();
-                            value = info.defaultValue_;     // For current frame to render correctly
+                            // Value is applied to item below, like any other modification.
+                            value = info.defaultValue_;
                             expireBuffers = true;
                             modified = true;
                         }
@@ -363,8 +424,9 @@ void AttributeInspector::RenderAttributes(const PODVector<Serializable*>& items)
                     modifiedLastFrame_ = info.name_.CString();
 
                     // Just started changing value of the attribute. Save old value required for event on modification end.
+                    // Item still holds unmodified value at this point.
                     if (!modifiedLastFrame)
-                        originalValue_ = oldValue;
+                        originalValue_ = item->GetAttribute(info.name_);
 
                     // Update attribute value and do nothing else for now.
                     item->SetAttribute(info.name_, value);
@@ -389,6 +451,57 @@ void AttributeInspector::RenderAttributes(const PODVector<Serializable*>& items)
         modifiedLastFrame_ = nullptr;
 }
 
+const PODVector<unsigned>& AttributeInspector::GetFilteredAttributes(Serializable* item)
+{
+    const auto* attributes = item->GetAttributes();
+    FilteredAttributes& cache = filterCache_[item->GetType()];
+
+    if (attributes == nullptr)
+    {
+        cache = FilteredAttributes();
+        return cache.indices_;
+    }
+
+    if (cache.attributes_ == attributes && cache.numAttributes_ == attributes->Size() && cache.filter_ == &filter_.front())
+        return cache.indices_;
+
+    cache.attributes_ = attributes;
+    cache.numAttributes_ = attributes->Size();
+    cache.filter_ = &filter_.front();
+    cache.indices_.Clear();
+
+    struct Match
+    {
+        unsigned index_;
+        int score_;
+    };
+    PODVector<Match> matches;
+    for (unsigned i = 0; i < attributes->Size(); i++)
+    {
+        const AttributeInfo& info = attributes->At(i);
+        if (info.mode_ & AM_NOEDIT)
+            continue;
+
+        int score = 0;
+        if (FuzzyMatch(cache.filter_, info.name_, &score))
+            matches.Push({i, score});
+    }
+
+    // Without a filter all scores are equal and attributes are kept in registration order.
+    if (!cache.filter_.Empty())
+    {
+        Sort(matches.Begin(), matches.End(), [](const Match& a, const Match& b) {
+            return a.score_ > b.score_ || (a.score_ == b.score_ && a.index_ < b.index_);
+        });
+    }
+
+    cache.indices_.Reserve(matches.Size());
+    for (const auto& match: matches)
+        cache.indices_.Push(match.index_);
+
+    return cache.indices_;
+}
+
 void AttributeInspector::RenderAttributes(Serializable* item)
 {
     PODVector<Serializable*> items;
@@ -504,7 +617,7 @@ bool AttributeInspector::RenderSingleAttribute(const AttributeInfo& info, Varian
             bool dirty = v != state->buffer_;
             if (dirty)
                 ui::PushStyleColor(ImGuiCol_Text, ui::GetStyle().Colors[ImGuiCol_TextDisabled]);
-            modified |= ui::InputText("", state->buffer_, IM_ARRAYSIZE(state->buffer_), ImGuiInputTextFlags_EnterReturnsTrue);
+            modified |= state->InputText(ImGuiInputTextFlags_EnterReturnsTrue);
             if (dirty)
             {
                 ui::PopStyleColor();
@@ -532,16 +645,27 @@ bool AttributeInspector::RenderSingleAttribute(const AttributeInfo& info, Varian
         }
         case VAR_RESOURCEREFLIST:
         {
-            auto& refList = value.GetResourceRefList();
-            for (auto i = 0; i < refList.names_.Size(); i++)
+            auto& refList = const_cast<ResourceRefList&>(value.GetResourceRefList());
+            bool expandable = refList.type_ == Material::GetTypeStatic();
+            unsigned start, end;
+            if (RenderArrayPager(refList.names_.Size(), start, end) && start < end)
+            {
+                // Elements start on a new line below page selector.
+                ui::PushID(start);
+                expanded = RenderAttributeLabel(info, Color::WHITE, expandable);
+                NextColumn();
+                ui::PopID();
+            }
+
+            // Element rows may have different height when materials are expanded, therefore they are paged, but not
+            // clipped.
+            for (auto i = start; i < end; i++)
             {
                 ui::PushID(i);
                 String result;
                 if (RenderResourceRef(refList.type_, refList.names_[i], result, expanded))
                 {
-                    ResourceRefList newRefList(refList);
-                    newRefList.names_[i] = result;
-                    value = newRefList;
+                    refList.names_[i] = result;
                     modified = true;
                     ui::PopID();
                     break;
@@ -549,10 +673,10 @@ bool AttributeInspector::RenderSingleAttribute(const AttributeInfo& info, Varian
                 ui::PopID();
 
                 // Render labels for multiple resources
-                if (i < refList.names_.Size() - 1)
+                if (i < end - 1)
                 {
                     ui::PushID(i + 1);
-                    expanded = RenderAttributeLabel(info, Color::WHITE, value.GetResourceRefList().type_ == Material::GetTypeStatic());
+                    expanded = RenderAttributeLabel(info, Color::WHITE, expandable);
                     NextColumn();
                     ui::PopID();
                 }
@@ -561,7 +685,32 @@ bool AttributeInspector::RenderSingleAttribute(const AttributeInfo& info, Varian
                 ui::NewLine();
             break;
         }
-//            case VAR_VARIANTVECTOR:
+        case VAR_VARIANTVECTOR:
+        {
+            auto& v = const_cast<VariantVector&>(value.GetVariantVector());
+            unsigned start, end;
+            // Elements start on a new line below attribute label or page selector. Element labels rendered on the
+            // value line would widen the label column every frame.
+            if (!RenderArrayPager(v.Size(), start, end))
+                ui::NewLine();
+
+            for (auto i = start; i < end; i++)
+            {
+                Variant& element = v[i];
+                AttributeInfo elementInfo;
+                elementInfo.type_ = element.GetType();
+                elementInfo.name_ = ToString("[%u]", i);
+
+                ui::PushID(i);
+                ui::Indent(attributeIndentLevel);
+                ui::TextUnformatted(elementInfo.name_.CString());
+                NextColumn();
+                modified |= RenderSingleAttribute(elementInfo, element, expanded);
+                ui::Unindent(attributeIndentLevel);
+                ui::PopID();
+            }
+            break;
+        }
 //            case VAR_VARIANTMAP:
         case VAR_INTRECT:
         {
@@ -627,70 +776,81 @@ bool AttributeInspector::RenderSingleAttribute(const AttributeInfo& info, Varian
         case VAR_STRINGVECTOR:
         {
             auto& v = const_cast<StringVector&>(value.GetStringVector());
+            unsigned oldSize = v.Size();
+            unsigned firstChanged = M_MAX_UNSIGNED;
 
             // Insert new item.
             {
                 AttributeInspectorBuffer* state = ui::GetUIState<AttributeInspectorBuffer>();
-                if (ui::InputText("", state->buffer_, IM_ARRAYSIZE(state->buffer_), ImGuiInputTextFlags_EnterReturnsTrue))
+                if (state->InputText(ImGuiInputTextFlags_EnterReturnsTrue))
                 {
                     v.Push(state->buffer_);
                     *state->buffer_ = 0;
                     modified = true;
-
-                    // Expire buffer of this new item just in case other item already used it.
-                    ui::PushID(v.Size());
-                    ui::ExpireUIState<AttributeInspectorBuffer>();
-                    ui::PopID();
+                    firstChanged = oldSize;
                 }
                 if (ui::IsItemHovered())
                     ui::SetTooltip("Press [Enter] to insert new item.");
             }
 
-            // List of current items.
-            unsigned index = 0;
-            for (auto it = v.Begin(); it != v.End();)
-            {
-                String& sv = *it;
+            // List of current items. Only items on current page that are not clipped by the window are rendered.
+            unsigned start, end;
+            RenderArrayPager(v.Size(), start, end);
 
-                ui::PushID(++index);
-                AttributeInspectorBuffer* state = ui::GetUIState<AttributeInspectorBuffer>(sv);
-                if (ui::Button(ICON_FA_TRASH))
-                {
-                    it = v.Erase(it);
-                    modified = true;
-                    ui::ExpireUIState<AttributeInspectorBuffer>();
-                }
-                else if (modified)
-                {
-                    // After modification of the vector all buffers are expired and recreated because their indexes
-                    // changed. Index is used as id in this loop.
-                    ui::ExpireUIState<AttributeInspectorBuffer>();
-                    ++it;
-                }
-                else
+            ImGuiListClipper clipper(end - start, ui::GetItemsLineHeightWithSpacing());
+            while (clipper.Step())
+            {
+                for (auto i = start + clipper.DisplayStart; i < start + clipper.DisplayEnd && i < v.Size(); i++)
                 {
-                    ui::SameLine();
+                    // Index is used as id in this loop, buffers of items are recreated after structural modification.
+                    if (firstChanged != M_MAX_UNSIGNED)
+                        break;
 
-                    bool dirty = sv != state->buffer_;
-                    if (dirty)
-                        ui::PushStyleColor(ImGuiCol_Text, ui::GetStyle().Colors[ImGuiCol_TextDisabled]);
-                    modified |= ui::InputText("", state->buffer_, IM_ARRAYSIZE(state->buffer_),
-                        ImGuiInputTextFlags_EnterReturnsTrue);
-                    if (dirty)
+                    String& sv = v[i];
+
+                    ui::PushID(i + 1);
+                    AttributeInspectorBuffer* state = ui::GetUIState<AttributeInspectorBuffer>(sv);
+                    if (ui::Button(ICON_FA_TRASH))
                     {
-                        ui::PopStyleColor();
-                        if (ui::IsItemHovered())
-                            ui::SetTooltip("Press [Enter] to commit changes.");
+                        v.Erase(i);
+                        modified = true;
+                        firstChanged = i;
                     }
-                    if (modified)
-                        sv = state->buffer_;
-                    ++it;
+                    else
+                    {
+                        ui::SameLine();
+
+                        bool dirty = sv != state->buffer_;
+                        if (dirty)
+                            ui::PushStyleColor(ImGuiCol_Text, ui::GetStyle().Colors[ImGuiCol_TextDisabled]);
+                        if (state->InputText(ImGuiInputTextFlags_EnterReturnsTrue))
+                        {
+                            // Only edited element is written to.
+                            sv = state->buffer_;
+                            modified = true;
+                        }
+                        if (dirty)
+                        {
+                            ui::PopStyleColor();
+                            if (ui::IsItemHovered())
+                                ui::SetTooltip("Press [Enter] to commit changes.");
+                        }
+                    }
+                    ui::PopID();
                 }
-                ui::PopID();
             }
 
-            if (modified)
-                value = StringVector(v);
+            // After insertion or removal indexes of items changed. Expire buffers of all shifted items, including ones
+            // that are not currently visible.
+            if (firstChanged != M_MAX_UNSIGNED)
+            {
+                for (auto i = firstChanged; i < Max(oldSize, v.Size()); i++)
+                {
+                    ui::PushID(i + 1);
+                    ui::ExpireUIState<AttributeInspectorBuffer>();
+                    ui::PopID();
+                }
+            }
 
             break;
         }
@@ -958,6 +1118,33 @@ void AttributeInspector::CopyEffectsFrom(Viewport* source)
     effectSource_ = source;
 }
 
+bool AttributeInspector::RenderArrayPager(unsigned size, unsigned& start, unsigned& end)
+{
+    start = 0;
+    end = size;
+    if (size <= attributeArrayPageSize)
+        return false;
+
+    unsigned numPages = (size + attributeArrayPageSize - 1) / attributeArrayPageSize;
+    auto* state = ui::GetUIState<AttributeInspectorArrayPage>();
+    state->page_ = Min(state->page_, numPages - 1);
+
+    if (ui::Button(ICON_FA_CHEVRON_LEFT) && state->page_ > 0)
+        state->page_--;
+    ui::SameLine();
+    start = state->page_ * attributeArrayPageSize;
+    end = Min(start + attributeArrayPageSize, size);
+    ui::Text("%u-%u of %u", start + 1, end, size);
+    ui::SameLine();
+    if (ui::Button(ICON_FA_CHEVRON_RIGHT) && state->page_ < numPages - 1)
+        state->page_++;
+
+    // Page may have changed after range was displayed.
+    start = state->page_ * attributeArrayPageSize;
+    end = Min(start + attributeArrayPageSize, size);
+    return true;
+}
+
 bool AttributeInspector::RenderAttributeLabel(const AttributeInfo& info, Color color, bool expandable)
 {
     bool expanded = false;
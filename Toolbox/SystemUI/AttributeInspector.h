@@ -47,6 +47,9 @@ public:
     void RenderAttributes(Serializable* item);
     /// Have resource views copy renderpath from source viewport.
     void CopyEffectsFrom(Viewport* source);
+    /// Forget filtered attribute lists. Should be called when per-instance attribute list of a serializable is rebuilt
+    /// in place.
+    void ClearFilterCache() { filterCache_.Clear(); }
     /// Automatically creates two columns where first column is as wide as longest label.
     void NextColumn();
 
@@ -56,11 +59,35 @@ protected:
     bool RenderSingleAttribute(const AttributeInfo& info, Variant& value, bool expanded);
     /// Render ui for single resource ref attribute.
     bool RenderResourceRef(StringHash type, const String& name, String& result, bool expanded);
+    /// Render page selector for array attribute with more elements than fit on one page.
+    /// \param size number of elements in the array.
+    /// \param start index of first element on current page.
+    /// \param end index one past last element on current page.
+    /// \returns true if page selector was rendered.
+    bool RenderArrayPager(unsigned size, unsigned& start, unsigned& end);
     /// Render single attribute label.
     bool RenderAttributeLabel(const AttributeInfo& info, Color color, bool expandable);
-
-    /// A filter value. Attributes whose titles do not contain substring sored in this variable will not be rendered.
+    /// Return indices of attributes of specified item that match current filter, best matches first. Result is cached
+    /// until filter value or attribute list of item type changes.
+    const PODVector<unsigned>& GetFilteredAttributes(Serializable* item);
+
+    /// Cached result of filtering attribute list of a single serializable type.
+    struct FilteredAttributes
+    {
+        /// Attribute list that was filtered. Some serializables provide per-instance attribute lists.
+        const Vector<AttributeInfo>* attributes_ = nullptr;
+        /// Size of attribute list at the time it was filtered.
+        unsigned numAttributes_ = 0;
+        /// Filter value that was used.
+        String filter_;
+        /// Indices of visible attributes sorted by match score.
+        PODVector<unsigned> indices_;
+    };
+
+    /// A filter value. Attributes whose titles do not fuzzy-match value stored in this variable will not be rendered.
     std::array<char, 0x100> filter_;
+    /// Visible attributes of each rendered serializable type.
+    HashMap<StringHash, FilteredAttributes> filterCache_;
     /// Last serializable whose attribute list was rendered.
     PODVector<Serializable*> lastSerializables_;
     /// Name of attribute that was modified on last frame.
@@ -20,12 +20,14 @@
 // THE SOFTWARE.
 //
 
+#include <Urho3D/Container/HashSet.h>
 #include <Urho3D/Graphics/Camera.h>
 #include <Urho3D/Scene/Node.h>
 #include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Input/Input.h>
 #include <Urho3D/UI/UI.h>
 #include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
 #include <Urho3D/Graphics/Octree.h>
 #include <Urho3D/Graphics/Graphics.h>
 #include <Urho3D/Graphics/GraphicsEvents.h>
@@ -41,6 +43,9 @@
 namespace Urho3D
 {
 
+/// Number of selected lights and drawables above which selection is outlined by a single bounding box.
+static const unsigned maxDebugBoundingBoxes = 512;
+
 Gizmo::Gizmo(Context* context) : Object(context)
 {
     SubscribeToEvent(E_POSTRENDERUPDATE, [&](StringHash, VariantMap&) { RenderDebugInfo(); });
@@ -134,52 +139,101 @@ bool Gizmo::Manipulate(const Camera* camera, const PODVector<Node*>& nodes)
 
         currentOrigin_ = Matrix4(tran);
 
-        for (const auto& node: nodes)
+        if (manipulatedNodes_.Empty())
+            BeginManipulation(nodes);
+
+        // Delta matrix is always in world-space. Filtered nodes do not depend on each other, so every node is marked
+        // dirty only once per frame. Nodes may be destroyed during manipulation, eg. by scene logic while playing.
+        if (operation_ == GIZMOOP_SCALE)
         {
-            if (node == nullptr)
+            // A workaround for ImGuizmo bug where delta matrix returns absolute scale value.
+            Vector3 scale = delta.Scale();
+            for (unsigned i = 0; i < manipulatedNodes_.Size(); i++)
             {
-                URHO3D_LOGERROR("Gizmo received null pointer of node.");
-                continue;
+                if (!manipulatedNodes_[i].Expired())
+                    manipulatedNodes_[i]->SetScale(nodeScaleStart_[i] * scale);
             }
-
-            if (operation_ == GIZMOOP_SCALE)
+        }
+        else if (operation_ == GIZMOOP_ROTATE)
+        {
+            Vector3 pivot = currentOrigin_.Translation();
+            Quaternion rotation = -delta.Rotation();
+            for (auto& node: manipulatedNodes_)
             {
-                // A workaround for ImGuizmo bug where delta matrix returns absolute scale value.
-                if (!nodeScaleStart_.Contains(node))
-                    nodeScaleStart_[node] = node->GetScale();
-                node->SetScale(nodeScaleStart_[node] * delta.Scale());
+                if (!node.Expired())
+                    node->RotateAround(pivot, rotation, TS_WORLD);
             }
-            else
+        }
+        else
+        {
+            Vector3 translation = delta.Translation();
+            for (auto& node: manipulatedNodes_)
             {
-                // Delta matrix is always in world-space.
-                if (operation_ == GIZMOOP_ROTATE)
-                    node->RotateAround(currentOrigin_.Translation(), -delta.Rotation(), TS_WORLD);
-                else
-                    node->Translate(delta.Translation(), TS_WORLD);
+                if (!node.Expired())
+                    node->Translate(translation, TS_WORLD);
             }
         }
 
         return true;
     }
-    else if (operation_ == GIZMOOP_SCALE && !nodeScaleStart_.Empty())
+    else if (!manipulatedNodes_.Empty())
+    {
+        manipulatedNodes_.Clear();
         nodeScaleStart_.Clear();
+    }
     return false;
 }
 
+void Gizmo::BeginManipulation(const PODVector<Node*>& nodes)
+{
+    // Scene is not manipulated, so it does not hide its selected children either.
+    HashSet<Node*> nodeSet;
+    for (Node* node: nodes)
+    {
+        if (node != nullptr && node->GetType() != Scene::GetTypeStatic())
+            nodeSet.Insert(node);
+    }
+
+    manipulatedNodes_.Reserve(nodes.Size());
+    nodeScaleStart_.Reserve(nodes.Size());
+    for (Node* node: nodes)
+    {
+        if (node == nullptr)
+        {
+            URHO3D_LOGERROR("Gizmo received null pointer of node.");
+            continue;
+        }
+
+        // Scene itself may not be manipulated as it does nothing.
+        if (node->GetType() == Scene::GetTypeStatic())
+            continue;
+
+        // Node is moved together with its selected ancestor. Transforming it as well would apply delta twice.
+        bool ancestorSelected = false;
+        for (Node* parent = node->GetParent(); parent != nullptr && !ancestorSelected; parent = parent->GetParent())
+            ancestorSelected = nodeSet.Contains(parent);
+        if (ancestorSelected)
+            continue;
+
+        manipulatedNodes_.Push(WeakPtr<Node>(node));
+        nodeScaleStart_.Push(node->GetScale());
+    }
+}
+
 bool Gizmo::ManipulateSelection(const Camera* camera)
 {
+    const auto& selection = GetSelection();
     PODVector<Node*> nodes;
-    nodes.Reserve(nodeSelection_.Size());
-    for (auto it = nodeSelection_.Begin(); it != nodeSelection_.End();)
+    nodes.Reserve(selection.Size());
+    for (const auto& node: selection)
     {
-        WeakPtr<Node> node = *it;
         if (node.Expired())
-            it = nodeSelection_.Erase(it);
-        else
         {
-            nodes.Push(node.Get());
-            ++it;
+            selectionHoles_ = true;
+            selectionVersion_++;
         }
+        else
+            nodes.Push(node.Get());
     }
     return Manipulate(camera, nodes);
 }
@@ -209,52 +263,168 @@ void Gizmo::RenderUI()
 
 bool Gizmo::Select(Node* node)
 {
-    WeakPtr<Node> weakNode(node);
-    if (nodeSelection_.Contains(weakNode))
+    if (node == nullptr || IsSelected(node))
         return false;
-    nodeSelection_.Push(weakNode);
+    // Stale index entry of expired node with the same address leaves expired slot behind.
+    if (selectionIndex_.Contains(node))
+        selectionHoles_ = true;
+    selectionIndex_[node] = nodeSelection_.Size();
+    nodeSelection_.Push(WeakPtr<Node>(node));
+    selectionVersion_++;
     return true;
 }
 
 bool Gizmo::Unselect(Node* node)
 {
-    WeakPtr<Node> weakNode(node);
-    if (!nodeSelection_.Contains(weakNode))
+    if (!IsSelected(node))
         return false;
-    nodeSelection_.Remove(weakNode);
+    // Removing from the middle of array is O(n), slot is cleared instead and array is compacted on next access.
+    nodeSelection_[selectionIndex_[node]].Reset();
+    selectionIndex_.Erase(node);
+    selectionHoles_ = true;
+    selectionVersion_++;
     return true;
 }
 
+bool Gizmo::Select(const PODVector<Node*>& nodes)
+{
+    bool changed = false;
+    for (Node* node: nodes)
+        changed |= Select(node);
+    return changed;
+}
+
+bool Gizmo::Unselect(const PODVector<Node*>& nodes)
+{
+    bool changed = false;
+    for (Node* node: nodes)
+        changed |= Unselect(node);
+    return changed;
+}
+
+const Vector<WeakPtr<Node>>& Gizmo::GetSelection() const
+{
+    CompactSelection();
+    return nodeSelection_;
+}
+
+void Gizmo::CompactSelection() const
+{
+    if (!selectionHoles_)
+        return;
+
+    unsigned count = 0;
+    selectionIndex_.Clear();
+    for (unsigned i = 0; i < nodeSelection_.Size(); i++)
+    {
+        if (nodeSelection_[i].Expired())
+            continue;
+        if (count != i)
+            nodeSelection_[count] = nodeSelection_[i];
+        selectionIndex_[nodeSelection_[count].Get()] = count;
+        count++;
+    }
+    nodeSelection_.Resize(count);
+    selectionHoles_ = false;
+}
+
 void Gizmo::RenderDebugInfo()
 {
-    DebugRenderer* debug = nullptr;
-    for (auto it = nodeSelection_.Begin(); it != nodeSelection_.End();)
+    if (debugCacheVersion_ != selectionVersion_ || debugCacheDirty_)
+        UpdateDebugCache();
+
+    DebugRenderer* debug = debugRenderer_;
+    if (debug == nullptr)
+        return;
+
+    // Large selections are outlined by a single box, so that debug geometry does not grow with selection size.
+    if (debugLights_.Size() + debugDrawables_.Size() > maxDebugBoundingBoxes)
+    {
+        BoundingBox bounds;
+        for (const auto& light: debugLights_)
+        {
+            if (!light.Expired())
+                bounds.Merge(light->GetWorldBoundingBox());
+        }
+        for (const auto& drawable: debugDrawables_)
+        {
+            if (!drawable.Expired())
+                bounds.Merge(drawable->GetWorldBoundingBox());
+        }
+        if (bounds.Defined())
+            debug->AddBoundingBox(bounds, Color::WHITE);
+        return;
+    }
+
+    for (const auto& light: debugLights_)
+    {
+        if (!light.Expired())
+            light->DrawDebugGeometry(debug, true);
+    }
+    for (const auto& drawable: debugDrawables_)
+    {
+        if (!drawable.Expired())
+            debug->AddBoundingBox(drawable->GetWorldBoundingBox(), Color::WHITE);
+    }
+    for (const auto& component: debugComponents_)
+    {
+        if (!component.Expired())
+            component->DrawDebugGeometry(debug, true);
+    }
+}
+
+void Gizmo::UpdateDebugCache()
+{
+    debugLights_.Clear();
+    debugDrawables_.Clear();
+    debugComponents_.Clear();
+    debugRenderer_.Reset();
+
+    Scene* scene = nullptr;
+    for (const auto& node: GetSelection())
     {
-        WeakPtr<Node> node = *it;
         if (node.Expired())
-            it = nodeSelection_.Erase(it);
-        else
+            continue;
+
+        if (scene == nullptr)
+            scene = node->GetScene();
+
+        for (auto& component: node->GetComponents())
         {
-            if (debug == nullptr)
-            {
-                if (auto scene = node->GetScene())
-                    debug = scene->GetComponent<DebugRenderer>();
-            }
-            if (debug != nullptr)
-            {
-                for (auto& component: node->GetComponents())
-                {
-                    if (auto light = dynamic_cast<Light*>(component.Get()))
-                        light->DrawDebugGeometry(debug, true);
-                    else if (auto drawable = dynamic_cast<Drawable*>(component.Get()))
-                        debug->AddBoundingBox(drawable->GetWorldBoundingBox(), Color::WHITE);
-                    else
-                        component->DrawDebugGeometry(debug, true);
-                }
-            }
-            ++it;
+            if (auto light = dynamic_cast<Light*>(component.Get()))
+                debugLights_.Push(WeakPtr<Light>(light));
+            else if (auto drawable = dynamic_cast<Drawable*>(component.Get()))
+                debugDrawables_.Push(WeakPtr<Drawable>(drawable));
+            else
+                debugComponents_.Push(WeakPtr<Component>(component));
+        }
+    }
+
+    // Components added to selected nodes have to be classified as well.
+    if (scene != debugScene_)
+    {
+        if (!debugScene_.Expired())
+        {
+            UnsubscribeFromEvent(debugScene_, E_COMPONENTADDED);
+            UnsubscribeFromEvent(debugScene_, E_COMPONENTREMOVED);
+        }
+        debugScene_ = scene;
+        if (scene != nullptr)
+        {
+            auto onComponentChanged = [&](StringHash, VariantMap& args) {
+                using namespace ComponentAdded;
+                if (IsSelected(static_cast<Node*>(args[P_NODE].GetPtr())))
+                    debugCacheDirty_ = true;
+            };
+            SubscribeToEvent(scene, E_COMPONENTADDED, onComponentChanged);
+            SubscribeToEvent(scene, E_COMPONENTREMOVED, onComponentChanged);
         }
     }
+
+    if (scene != nullptr)
+        debugRenderer_ = scene->GetComponent<DebugRenderer>();
+    debugCacheVersion_ = selectionVersion_;
+    debugCacheDirty_ = false;
 }
 
 void Gizmo::HandleAutoSelection()
@@ -295,7 +465,7 @@ void Gizmo::HandleAutoSelection()
         {
             WeakPtr<Node> clickNode(results[0].drawable_->GetNode());
             if (!GetInput()->GetKeyDown(KEY_CTRL))
-                nodeSelection_.Clear();
+                UnselectAll();
 
             ToggleSelection(clickNode);
         }
@@ -349,13 +519,17 @@ bool Gizmo::UnselectAll()
     if (nodeSelection_.Empty())
         return false;
     nodeSelection_.Clear();
+    selectionIndex_.Clear();
+    selectionHoles_ = false;
+    selectionVersion_++;
     return true;
 }
 
 bool Gizmo::IsSelected(Node* node) const
 {
-    WeakPtr<Node> pNode(node);
-    return nodeSelection_.Contains(pNode);
+    auto it = selectionIndex_.Find(node);
+    // Index may still contain a node which expired and whose address was reused. Weak pointer of such slot is null.
+    return it != selectionIndex_.End() && nodeSelection_[it->second_].Get() == node;
 }
 
 void Gizmo::SetScreenRect(const IntVector2& pos, const IntVector2& size)
@@ -31,7 +31,11 @@ namespace Urho3D
 {
 
 class Camera;
+class DebugRenderer;
+class Drawable;
+class Light;
 class Node;
+class Scene;
 
 enum GizmoOperation
 {
@@ -80,6 +84,10 @@ public:
     bool Select(Node* node);
     /// Remove a node from selection.
     bool Unselect(Node* node);
+    /// Add multiple nodes to selection. Returns true if selection changed.
+    bool Select(const PODVector<Node*>& nodes);
+    /// Remove multiple nodes from selection. Returns true if selection changed.
+    bool Unselect(const PODVector<Node*>& nodes);
     /// Select if node was not selected or unselect if node was selected.
     void ToggleSelection(Node* node);
     /// Unselect all nodes.
@@ -88,8 +96,10 @@ public:
     bool IsSelected(Node* node) const;
     /// Enable auto-selection and gizmo rendering on scene to which specified camera belongs.
     void EnableAutoMode(Camera* camera);
-    /// Return list of selected nodes.
-    const Vector<WeakPtr<Node>>& GetSelection() const { return nodeSelection_; }
+    /// Return list of selected nodes in the order they were selected.
+    const Vector<WeakPtr<Node>>& GetSelection() const;
+    /// Return selection version. It changes every time selection changes.
+    unsigned GetSelectionVersion() const { return selectionVersion_; }
     /// Set screen rect to which gizmo rendering will be limited. Use when putting gizmo in a window.
     void SetScreenRect(const IntVector2& pos, const IntVector2& size);
     /// Set screen rect to which gizmo rendering will be limited. Use when putting gizmo in a window.
@@ -98,19 +108,48 @@ public:
 protected:
     /// Renders debug info of selected nodes if scene has debug renderer component.
     void RenderDebugInfo();
+    /// Classify components of selected nodes for debug rendering.
+    void UpdateDebugCache();
     /// Process mouse clicks and auto-select nodes.
     void HandleAutoSelection();
+    /// Collect nodes transformed by operation which is starting.
+    void BeginManipulation(const PODVector<Node*>& nodes);
+    /// Remove unselected and expired nodes from selection array and rebuild selection index.
+    void CompactSelection() const;
 
     /// Current gizmo operation. Translation, rotation or scaling.
     GizmoOperation operation_ = GIZMOOP_TRANSLATE;
     /// Current coordinate space to operate in. World or local.
     TransformSpace transformSpace_ = TS_WORLD;
-    /// Saved node scale on operation start.
-    HashMap<Node*, Vector3> nodeScaleStart_;
+    /// Nodes transformed by current operation. Nodes whose ancestors are manipulated as well are excluded.
+    Vector<WeakPtr<Node>> manipulatedNodes_;
+    /// Saved scale of manipulatedNodes_ on operation start.
+    PODVector<Vector3> nodeScaleStart_;
     /// Current operation origin. This is center point between all nodes that are being manipulated.
     Matrix4 currentOrigin_;
-    /// Current node selection. Nodes removed from the scene are automatically unselected.
-    Vector<WeakPtr<Node> > nodeSelection_;
+    /// Current node selection. Nodes removed from the scene are automatically unselected. Unselected nodes leave
+    /// empty slots which are removed lazily by CompactSelection().
+    mutable Vector<WeakPtr<Node> > nodeSelection_;
+    /// Selected nodes mapped to their index in nodeSelection_.
+    mutable HashMap<Node*, unsigned> selectionIndex_;
+    /// Flag indicating that nodeSelection_ contains empty or expired slots.
+    mutable bool selectionHoles_ = false;
+    /// Selection version, incremented on every selection change.
+    mutable unsigned selectionVersion_ = 0;
+    /// Lights of selected nodes.
+    Vector<WeakPtr<Light>> debugLights_;
+    /// Drawables of selected nodes, except lights.
+    Vector<WeakPtr<Drawable>> debugDrawables_;
+    /// Other components of selected nodes.
+    Vector<WeakPtr<Component>> debugComponents_;
+    /// Debug renderer of scene selected nodes belong to.
+    WeakPtr<DebugRenderer> debugRenderer_;
+    /// Scene whose component events are observed for keeping debug cache up to date.
+    WeakPtr<Scene> debugScene_;
+    /// Selection version debug cache was built for.
+    unsigned debugCacheVersion_ = M_MAX_UNSIGNED;
+    /// Flag indicating that components of selected nodes changed.
+    bool debugCacheDirty_ = false;
     /// Camera which is used for automatic node selection in the scene camera belongs to.
     WeakPtr<Camera> autoModeCamera_;
     ImVec2 displayPos_{};
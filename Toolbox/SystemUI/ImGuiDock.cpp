@@ -23,6 +23,8 @@
 #include "ImGuiDock.h"
 #define IMGUI_DEFINE_PLACEMENT_NEW
 #include <imgui/imgui_internal.h>
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/HashSet.h>
 #include <Urho3D/Core/StringUtils.h>
 #include <Utils.h>
 
@@ -65,15 +67,13 @@ struct DockContext
             , opened(false)
             , first(true)
             , last_frame(0)
+            , index(-1)
         {
             location[0] = 0;
             children[0] = children[1] = nullptr;
         }
 
 
-        ~Dock() { MemFree(label); }
-
-
         ImVec2 getMinSize() const
         {
             if (!children[0]) return ImVec2(16, 16 + GetTextLineHeightWithSpacing());
@@ -189,7 +189,8 @@ struct DockContext
         }
 
 
-        char* label;
+        /// Interned by DockContext, owned by m_labels.
+        const char* label;
         ImU32 id;
         Dock* next_tab;
         Dock* prev_tab;
@@ -203,12 +204,25 @@ struct DockContext
         bool opened;
         bool first;
         int last_frame;
+        /// Position of this dock in DockContext::m_docks.
+        int index;
         ImGuiCond_ m_allow_condition = ImGuiCond_Always | ImGuiCond_Once | ImGuiCond_FirstUseEver | ImGuiCond_Appearing;
         bool m_tab_hovered = false;
     };
 
 
+    /// Number of docks allocated at once when dock pool runs out of free docks.
+    static const int DOCK_POOL_CHUNK_SIZE = 32;
+
     ImVector<Dock*> m_docks;
+    /// Dock id to dock lookup.
+    Urho3D::HashMap<ImU32, Dock*> m_dock_index;
+    /// Memory blocks backing all docks, each holds DOCK_POOL_CHUNK_SIZE docks.
+    ImVector<Dock*> m_dock_chunks;
+    /// Unused docks from m_dock_chunks.
+    ImVector<Dock*> m_free_docks;
+    /// Interned dock labels.
+    Urho3D::HashSet<Urho3D::String> m_labels;
     ImVec2 m_drag_offset;
     Dock* m_current = nullptr;
     int m_last_frame = 0;
@@ -221,29 +235,82 @@ struct DockContext
 
     ~DockContext() {}
 
-    Dock* getExistingDock(ImU32 id)
+    const char* internLabel(const char* label)
     {
-        for (int i = 0; i < m_docks.size(); ++i)
+        return m_labels.Insert(Urho3D::String(label))->CString();
+    }
+
+    Dock* allocDock()
+    {
+        if (m_free_docks.empty())
         {
-            if (m_docks[i]->id == id) return m_docks[i];
+            Dock* chunk = (Dock*)MemAlloc(sizeof(Dock) * DOCK_POOL_CHUNK_SIZE);
+            m_dock_chunks.push_back(chunk);
+            for (int i = DOCK_POOL_CHUNK_SIZE - 1; i >= 0; --i)
+                m_free_docks.push_back(chunk + i);
         }
-        return nullptr;
+
+        Dock* dock = m_free_docks.back();
+        m_free_docks.pop_back();
+        IM_PLACEMENT_NEW(dock) Dock();
+        dock->index = m_docks.size();
+        m_docks.push_back(dock);
+        return dock;
     }
 
-    Dock& getDock(const char* label, bool opened, const ImVec2& default_size)
+    void releaseDock(Dock* dock)
+    {
+        auto it = m_dock_index.Find(dock->id);
+        if (it != m_dock_index.End() && it->second_ == dock)
+            m_dock_index.Erase(it);
+
+        int index = dock->index;
+        IM_ASSERT(m_docks[index] == dock);
+        m_docks.erase(m_docks.begin() + index);
+        for (int i = index; i < m_docks.size(); ++i)
+            m_docks[i]->index = i;
+
+        dock->~Dock();
+        m_free_docks.push_back(dock);
+    }
+
+    void clearDocks()
     {
-        ImU32 id = ImHash(label, 0);
         for (int i = 0; i < m_docks.size(); ++i)
         {
-            if (m_docks[i]->id == id) return *m_docks[i];
+            m_docks[i]->~Dock();
+            m_free_docks.push_back(m_docks[i]);
         }
+        m_docks.clear();
+        m_dock_index.Clear();
+        m_labels.Clear();
+    }
+
+    void shutdown()
+    {
+        clearDocks();
+        for (int i = 0; i < m_dock_chunks.size(); ++i)
+            MemFree(m_dock_chunks[i]);
+        m_dock_chunks.clear();
+        m_free_docks.clear();
+    }
 
-        Dock* new_dock = (Dock*)MemAlloc(sizeof(Dock));
-        IM_PLACEMENT_NEW(new_dock) Dock();
-        m_docks.push_back(new_dock);
-        new_dock->label = ImStrdup(label);
-        IM_ASSERT(new_dock->label);
+    Dock* getExistingDock(ImU32 id)
+    {
+        auto it = m_dock_index.Find(id);
+        return it != m_dock_index.End() ? it->second_ : nullptr;
+    }
+
+    Dock& getDock(const char* label, bool opened, const ImVec2& default_size)
+    {
+        ImU32 id = ImHash(label, 0);
+        if (Dock* dock = getExistingDock(id))
+            return *dock;
+
+        Dock* new_dock = allocDock();
+        new_dock->label = internLabel(label);
         new_dock->id = id;
+        m_dock_index[id] = new_dock;
         new_dock->setActive();
         new_dock->status = Status_Float;
         new_dock->pos = ImVec2(0, 0);
@@ -585,16 +652,7 @@ struct DockContext
                         container->children[1]->setPosSize(container->pos, container->size);
                     }
                 }
-                for (int i = 0; i < m_docks.size(); ++i)
-                {
-                    if (m_docks[i] == container)
-                    {
-                        m_docks.erase(m_docks.begin() + i);
-                        break;
-                    }
-                }
-                container->~Dock();
-                MemFree(container);
+                releaseDock(container);
             }
         }
         if (dock.prev_tab) dock.prev_tab->next_tab = dock.next_tab;
@@ -804,9 +862,7 @@ struct DockContext
         }
         else
         {
-            Dock* container = (Dock*)MemAlloc(sizeof(Dock));
-            IM_PLACEMENT_NEW(container) Dock();
-            m_docks.push_back(container);
+            Dock* container = allocDock();
             container->children[0] = &dest->getFirstTab();
             container->children[1] = &dock;
             container->next_tab = nullptr;
@@ -815,7 +871,7 @@ struct DockContext
             container->size = dest->size;
             container->pos = dest->pos;
             container->status = Status_Docked;
-            container->label = ImStrdup("");
+            container->label = internLabel("");
 
             if (!dest->parent)
             {
@@ -851,18 +907,18 @@ struct DockContext
         static bool is_first_call = true;
         if (!is_first_call)
         {
-            for (auto it = m_docks.begin(); it != m_docks.end();)
+            for (int i = 0; i < m_docks.size();)
             {
-                auto& dock = *it;
+                Dock* dock = m_docks[i];
                 if (!dock->hasChildren() && dock != root && (ImGui::GetFrameCount() - dock->last_frame) > 1)
                 {
+                    // Undocking may release a container placed before this dock, index is updated accordingly.
                     doUndock(*dock);
-                    dock->~Dock();
-                    MemFree(dock);
-                    it = m_docks.erase(it);
+                    i = dock->index;
+                    releaseDock(dock);
                 }
                 else
-                    ++it;
+                    ++i;
             }
         }
         is_first_call = false;
@@ -984,10 +1040,7 @@ struct DockContext
         dock.last_frame = ImGui::GetFrameCount();
         if (!dock.opened && (!opened || *opened)) tryDockToStoredLocation(dock);
         if (strcmp(dock.label, label) != 0)
-        {
-            MemFree(dock.label);
-            dock.label = ImStrdup(label);
-        }
+            dock.label = internLabel(label);
 
         m_end_action = EndAction_None;
 
@@ -1092,13 +1145,8 @@ struct DockContext
     {
         if (!dock) return -1;
 
-        for (int i = 0; i < m_docks.size(); ++i)
-        {
-            if (dock == m_docks[i]) return i;
-        }
-
-        IM_ASSERT(false);
-        return -1;
+        IM_ASSERT(dock->index >= 0 && dock->index < m_docks.size() && m_docks[dock->index] == dock);
+        return dock->index;
     }
 
 
@@ -1108,7 +1156,7 @@ struct DockContext
         {
             auto file = docks.CreateChild("dock");
             Dock& dock = *m_docks[i];
-            file.SetAttribute("index", Urho3D::ToString("%d", i));
+            file.SetAttribute("index", Urho3D::ToString("%d", dock.index));
             file.SetAttribute("label", dock.label);
             file.SetAttribute("x", Urho3D::ToString("%d", (int)dock.pos.x));
             file.SetAttribute("y", Urho3D::ToString("%d", (int)dock.pos.y));
@@ -1127,40 +1175,38 @@ struct DockContext
     }
 
 
-    Dock* getDockByIndex(int idx) { return idx < 0 ? nullptr : m_docks[idx]; }
+    Dock* getDockByIndex(int idx) { return idx < 0 || idx >= m_docks.size() ? nullptr : m_docks[idx]; }
 
 
     void load(Urho3D::XMLElement element)
     {
-        for (int i = 0; i < m_docks.size(); ++i)
-        {
-            m_docks[i]->~Dock();
-            MemFree(m_docks[i]);
-        }
-        m_docks.clear();
+        clearDocks();
 
         auto record = element.GetChild("dock");
         while (record.NotNull())
         {
-            Dock* new_dock = (Dock*)MemAlloc(sizeof(Dock));
-            m_docks.push_back(IM_PLACEMENT_NEW(new_dock) Dock());
+            allocDock();
             record = record.GetNext("dock");
         }
 
         record = element.GetChild("dock");
         while (record.NotNull())
         {
-            int idx = Urho3D::ToInt(record.GetAttribute("index"));
-            Dock& dock = *m_docks[idx];
-            dock.label = ImStrdup(record.GetAttribute("label").CString());
-            dock.id = ImHash(dock.label, 0);
+            Dock* loaded = getDockByIndex(Urho3D::ToInt(record.GetAttribute("index")));
+            if (loaded == nullptr)
+            {
+                record = record.GetNext("dock");
+                continue;
+            }
+            Dock& dock = *loaded;
+            setLoadedDockLabel(dock, record.GetAttribute("label").CString());
             dock.pos.x = Urho3D::ToFloat(record.GetAttribute("x"));
             dock.pos.y = Urho3D::ToFloat(record.GetAttribute("y"));
             dock.size.x = Urho3D::ToFloat(record.GetAttribute("size_x"));
             dock.size.y = Urho3D::ToFloat(record.GetAttribute("size_y"));
             dock.active = Urho3D::ToInt(record.GetAttribute("active")) != 0;
             dock.opened = Urho3D::ToInt(record.GetAttribute("opened")) != 0;
-            strcpy(dock.location, record.GetAttribute("location").CString());
+            ImStrncpy(dock.location, record.GetAttribute("location").CString(), IM_ARRAYSIZE(dock.location));
             dock.status = (Status_)Urho3D::ToInt(record.GetAttribute("status"));
             dock.prev_tab = getDockByIndex(Urho3D::ToInt(record.GetAttribute("prev")));
             dock.next_tab = getDockByIndex(Urho3D::ToInt(record.GetAttribute("next")));
@@ -1172,6 +1218,71 @@ struct DockContext
         }
     }
 
+
+    void save(Urho3D::Serializer& dest)
+    {
+        dest.WriteVLE((unsigned)m_docks.size());
+        for (int i = 0; i < m_docks.size(); ++i)
+        {
+            Dock& dock = *m_docks[i];
+            dest.WriteString(dock.label);
+            dest.WriteString(dock.location);
+            dest.WriteFloat(dock.pos.x);
+            dest.WriteFloat(dock.pos.y);
+            dest.WriteFloat(dock.size.x);
+            dest.WriteFloat(dock.size.y);
+            dest.WriteUByte((unsigned char)dock.status);
+            dest.WriteBool(dock.active);
+            dest.WriteBool(dock.opened);
+            dest.WriteInt(getDockIndex(dock.prev_tab));
+            dest.WriteInt(getDockIndex(dock.next_tab));
+            dest.WriteInt(getDockIndex(dock.children[0]));
+            dest.WriteInt(getDockIndex(dock.children[1]));
+            dest.WriteInt(getDockIndex(dock.parent));
+        }
+    }
+
+
+    void load(Urho3D::Deserializer& source)
+    {
+        clearDocks();
+
+        // Docks are stored in m_docks order, so position in the stream is the dock index.
+        unsigned count = source.ReadVLE();
+        for (unsigned i = 0; i < count; ++i)
+            allocDock();
+
+        for (int i = 0; i < m_docks.size(); ++i)
+        {
+            Dock& dock = *m_docks[i];
+            setLoadedDockLabel(dock, source.ReadString().CString());
+            ImStrncpy(dock.location, source.ReadString().CString(), IM_ARRAYSIZE(dock.location));
+            dock.pos.x = source.ReadFloat();
+            dock.pos.y = source.ReadFloat();
+            dock.size.x = source.ReadFloat();
+            dock.size.y = source.ReadFloat();
+            dock.status = (Status_)source.ReadUByte();
+            dock.active = source.ReadBool();
+            dock.opened = source.ReadBool();
+            dock.prev_tab = getDockByIndex(source.ReadInt());
+            dock.next_tab = getDockByIndex(source.ReadInt());
+            dock.children[0] = getDockByIndex(source.ReadInt());
+            dock.children[1] = getDockByIndex(source.ReadInt());
+            dock.parent = getDockByIndex(source.ReadInt());
+            dock.m_allow_condition &= ~ImGuiCond_FirstUseEver;
+        }
+    }
+
+
+    void setLoadedDockLabel(Dock& dock, const char* label)
+    {
+        dock.label = internLabel(label);
+        dock.id = ImHash(dock.label, 0);
+        // First dock with a given id wins, same as the linear lookup did.
+        if (!m_dock_index.Contains(dock.id))
+            m_dock_index[dock.id] = &dock;
+    }
+
     void placeNewDockAfter(const char* label, DockSlot_ slot, ImGuiCond_ condition)
     {
         if (label)
@@ -1212,12 +1323,7 @@ static DockContext g_dock;
 
 void ShutdownDock()
 {
-    for (int i = 0; i < g_dock.m_docks.size(); ++i)
-    {
-        g_dock.m_docks[i]->~Dock();
-        MemFree(g_dock.m_docks[i]);
-    }
-    g_dock.m_docks.clear();
+    g_dock.shutdown();
 }
 
 
@@ -1256,6 +1362,18 @@ void LoadDock(Urho3D::XMLElement element)
     g_dock.load(element);
 }
 
+
+void SaveDock(Urho3D::Serializer& dest)
+{
+    g_dock.save(dest);
+}
+
+
+void LoadDock(Urho3D::Deserializer& source)
+{
+    g_dock.load(source);
+}
+
 void SetNextDockPos(const char* targetDockLabel, DockSlot_ pos, ImGuiCond_ condition)
 {
     g_dock.placeNewDockAfter(targetDockLabel, pos, condition);
@@ -24,6 +24,8 @@
 
 
 #include <imgui/imgui.h>
+#include <Urho3D/IO/Deserializer.h>
+#include <Urho3D/IO/Serializer.h>
 #include <Urho3D/Resource/XMLElement.h>
 
 namespace ImGui
@@ -48,6 +50,8 @@ void EndDock();
 void SetDockActive();
 void SaveDock(Urho3D::XMLElement element);
 void LoadDock(Urho3D::XMLElement element);
+void SaveDock(Urho3D::Serializer& dest);
+void LoadDock(Urho3D::Deserializer& source);
 void SetNextDockPos(const char* targetDockLabel, DockSlot_ pos, ImGuiCond_ condition);
 bool IsDockDocked();
 bool IsDockActive();
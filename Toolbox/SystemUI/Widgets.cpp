@@ -21,6 +21,7 @@
 //
 
 #include "Widgets.h"
+#include <Urho3D/Container/Allocator.h>
 #include <Urho3D/Core/Context.h>
 #include <SDL/SDL_scancode.h>
 #include <imgui/imgui_internal.h>
@@ -31,91 +32,275 @@ namespace ImGui
 {
 
 const unsigned UISTATE_EXPIRATION_MS = 30000;
+/// Max number of expired ui states freed on a single frame.
+const unsigned UISTATE_MAX_EXPIRED_PER_FRAME = 64;
+/// Number of low handle bits that store slot index. Remaining bits store slot generation.
+const unsigned UISTATE_INDEX_BITS = 20;
+const unsigned UISTATE_INDEX_MASK = (1u << UISTATE_INDEX_BITS) - 1;
+const unsigned UISTATE_GENERATION_MASK = (1u << (32 - UISTATE_INDEX_BITS)) - 1;
+/// Marks end of slot list.
+const unsigned UISTATE_INVALID_SLOT = UISTATE_INDEX_MASK;
+/// Block size of smallest ui state memory size class.
+const unsigned UISTATE_MIN_BLOCK_SIZE = 16;
+/// Number of ui state memory size classes. Each size class doubles block size, largest block is 4 KB.
+const int UISTATE_NUM_SIZE_CLASSES = 9;
+/// Number of blocks allocated when size class pool is first used.
+const unsigned UISTATE_INITIAL_POOL_CAPACITY = 16;
+
+/// Slot of ui state storage. Live slots are linked in least recently used order, free slots are linked into a free list.
+struct UIStateSlot
+{
+    /// Id stack position state belongs to.
+    ImGuiID id_;
+    /// User state pointer.
+    void* state_;
+    /// Function that handles deleting state object when it becomes unused.
+    void(*deleter_)(void* state);
+    /// Time of last access in milliseconds.
+    unsigned lastUsed_;
+    /// Incremented each time slot is freed. Handles with old generation are invalid.
+    unsigned generation_;
+    /// Previous slot in the list. More recently used slot for live slots.
+    unsigned prev_;
+    /// Next slot in the list. Less recently used slot for live slots, next free slot for free slots.
+    unsigned next_;
+};
 
-struct UIStateWrapper
+/// Slab of ui state slots. Slots are addressed by index and never move in the list.
+Urho3D::PODVector<UIStateSlot> uiStateSlots_;
+/// Maps id stack position to a slot handle.
+Urho3D::HashMap<ImGuiID, unsigned> uiStateHandles_;
+/// Most recently used live slot.
+unsigned uiStateHead_ = UISTATE_INVALID_SLOT;
+/// Least recently used live slot.
+unsigned uiStateTail_ = UISTATE_INVALID_SLOT;
+/// First free slot.
+unsigned uiStateFree_ = UISTATE_INVALID_SLOT;
+/// Number of live ui states.
+unsigned uiStateCount_ = 0;
+/// Number of bytes of ui state memory in use.
+unsigned uiStateBytes_ = 0;
+/// Frame on which expired states were last collected.
+int uiStateLastCollectFrame_ = -1;
+/// Clock for timestamping ui state access.
+Urho3D::Timer uiStateClock_;
+/// Fixed block size pools, one for each size class.
+Urho3D::AllocatorBlock* uiStatePools_[UISTATE_NUM_SIZE_CLASSES]{};
+
+/// Return index of smallest size class that fits specified size or -1 if size is too big to be pooled.
+static int GetUIStateSizeClass(unsigned size)
 {
-    void Set(void* state, void(*deleter)(void*)=nullptr)
+    unsigned blockSize = UISTATE_MIN_BLOCK_SIZE;
+    for (int i = 0; i < UISTATE_NUM_SIZE_CLASSES; i++, blockSize <<= 1)
     {
-        state_ = state;
-        deleter_ = deleter;
+        if (size <= blockSize)
+            return i;
     }
+    return -1;
+}
 
-    void Unset()
+void* AllocateUIStateMemory(unsigned size)
+{
+    int sizeClass = GetUIStateSizeClass(size);
+    if (sizeClass < 0)
     {
-        if (deleter_ && state_)
-            deleter_(state_);
-        state_ = nullptr;
-        deleter_ = nullptr;
+        uiStateBytes_ += size;
+        return new unsigned char[size];
     }
 
-    void* Get(bool keepAlive=true)
+    auto& pool = uiStatePools_[sizeClass];
+    if (pool == nullptr)
+        pool = Urho3D::AllocatorInitialize(UISTATE_MIN_BLOCK_SIZE << sizeClass, UISTATE_INITIAL_POOL_CAPACITY);
+    uiStateBytes_ += UISTATE_MIN_BLOCK_SIZE << sizeClass;
+    return Urho3D::AllocatorReserve(pool);
+}
+
+void FreeUIStateMemory(void* memory, unsigned size)
+{
+    if (memory == nullptr)
+        return;
+
+    int sizeClass = GetUIStateSizeClass(size);
+    if (sizeClass < 0)
     {
-        if (keepAlive)
-            timer_.Reset();
-        return state_;
+        uiStateBytes_ -= size;
+        delete[] (unsigned char*)memory;
     }
-
-    bool IsExpired()
+    else
     {
-        return timer_.GetMSec(false) >= UISTATE_EXPIRATION_MS;
+        uiStateBytes_ -= UISTATE_MIN_BLOCK_SIZE << sizeClass;
+        Urho3D::AllocatorFree(uiStatePools_[sizeClass], memory);
     }
+}
 
-protected:
-    /// User state pointer.
-    void* state_ = nullptr;
-    /// Function that handles deleting state object when it becomes unused.
-    void(*deleter_)(void* state) = nullptr;
-    /// Timer which determines when state expires.
-    Urho3D::Timer timer_;
-};
+/// Remove slot from the list of live slots.
+static void UnlinkUIStateSlot(unsigned index)
+{
+    UIStateSlot& slot = uiStateSlots_[index];
+    if (slot.prev_ != UISTATE_INVALID_SLOT)
+        uiStateSlots_[slot.prev_].next_ = slot.next_;
+    else
+        uiStateHead_ = slot.next_;
+
+    if (slot.next_ != UISTATE_INVALID_SLOT)
+        uiStateSlots_[slot.next_].prev_ = slot.prev_;
+    else
+        uiStateTail_ = slot.prev_;
+}
 
-Urho3D::HashMap<ImGuiID, UIStateWrapper> uiState_;
+/// Insert slot at the head of the list of live slots.
+static void LinkUIStateSlot(unsigned index)
+{
+    UIStateSlot& slot = uiStateSlots_[index];
+    slot.prev_ = UISTATE_INVALID_SLOT;
+    slot.next_ = uiStateHead_;
+    if (uiStateHead_ != UISTATE_INVALID_SLOT)
+        uiStateSlots_[uiStateHead_].prev_ = index;
+    uiStateHead_ = index;
+    if (uiStateTail_ == UISTATE_INVALID_SLOT)
+        uiStateTail_ = index;
+}
 
-void SetUIStateP(void* state, void(*deleter)(void*))
+/// Mark live slot as used now and move it to the head of the list.
+static void TouchUIStateSlot(unsigned index)
 {
-    auto id = ui::GetCurrentWindow()->IDStack.back();
-    uiState_[id].Set(state, deleter);
+    uiStateSlots_[index].lastUsed_ = uiStateClock_.GetMSec(false);
+    if (uiStateHead_ == index)
+        return;
+
+    UnlinkUIStateSlot(index);
+    LinkUIStateSlot(index);
 }
 
-void* GetUIStateP()
+/// Return slot index of specified handle or UISTATE_INVALID_SLOT if handle is stale.
+static unsigned GetUIStateSlot(unsigned handle)
 {
-    void* result = nullptr;
-    auto id = ui::GetCurrentWindow()->IDStack.back();
-    auto it = uiState_.Find(id);
-    if (it != uiState_.End())
-        result = it->second_.Get();
+    unsigned index = handle & UISTATE_INDEX_MASK;
+    if (index >= uiStateSlots_.Size() || uiStateSlots_[index].generation_ != handle >> UISTATE_INDEX_BITS)
+        return UISTATE_INVALID_SLOT;
+    return index;
+}
+
+/// Free user state and return slot to the free list.
+static void FreeUIStateSlot(unsigned index)
+{
+    UIStateSlot& slot = uiStateSlots_[index];
+    UnlinkUIStateSlot(index);
+    uiStateHandles_.Erase(slot.id_);
+
+    // Deleter may access ui state storage, therefore slot is freed before state is deleted.
+    void* state = slot.state_;
+    void(*deleter)(void*) = slot.deleter_;
+    slot.state_ = nullptr;
+    slot.deleter_ = nullptr;
+    slot.generation_ = (slot.generation_ + 1) & UISTATE_GENERATION_MASK;
+    slot.prev_ = UISTATE_INVALID_SLOT;
+    slot.next_ = uiStateFree_;
+    uiStateFree_ = index;
+    uiStateCount_--;
+
+    if (deleter && state)
+        deleter(state);
+}
+
+/// Free least recently used states that were not accessed for UISTATE_EXPIRATION_MS. Runs once per frame and frees a
+/// limited number of states, so cost of expiring many states is spread over multiple frames.
+static void CollectExpiredUIState()
+{
+    int frame = ui::GetFrameCount();
+    if (uiStateLastCollectFrame_ == frame)
+        return;
+    uiStateLastCollectFrame_ = frame;
 
-    // Every 30s check all saved states and remove expired ones.
-    static Urho3D::Timer gcTimer;
-    if (gcTimer.GetMSec(false) > UISTATE_EXPIRATION_MS)
+    unsigned now = uiStateClock_.GetMSec(false);
+    for (unsigned i = 0; i < UISTATE_MAX_EXPIRED_PER_FRAME && uiStateTail_ != UISTATE_INVALID_SLOT; i++)
     {
-        gcTimer.Reset();
+        if (now - uiStateSlots_[uiStateTail_].lastUsed_ < UISTATE_EXPIRATION_MS)
+            break;
+        FreeUIStateSlot(uiStateTail_);
+    }
+}
+
+void SetUIStateP(void* state, void(*deleter)(void*))
+{
+    auto id = ui::GetCurrentWindow()->IDStack.back();
+    unsigned index = UISTATE_INVALID_SLOT;
+    auto it = uiStateHandles_.Find(id);
+    if (it != uiStateHandles_.End())
+        index = GetUIStateSlot(it->second_);
 
-        for (auto jt = uiState_.Begin(); jt != uiState_.End();)
+    if (index != UISTATE_INVALID_SLOT)
+    {
+        // Replace state at this position.
+        UIStateSlot& slot = uiStateSlots_[index];
+        if (slot.state_ != state && slot.deleter_ && slot.state_)
+            slot.deleter_(slot.state_);
+    }
+    else
+    {
+        if (uiStateFree_ != UISTATE_INVALID_SLOT)
         {
-            if (jt->second_.IsExpired())
-            {
-                jt->second_.Unset();
-                jt = uiState_.Erase(jt);
-            }
-            else
-                ++jt;
+            index = uiStateFree_;
+            uiStateFree_ = uiStateSlots_[index].next_;
+        }
+        else
+        {
+            index = uiStateSlots_.Size();
+            assert(index < UISTATE_INVALID_SLOT);
+            uiStateSlots_.Push(UIStateSlot{0, nullptr, nullptr, 0, 0, UISTATE_INVALID_SLOT, UISTATE_INVALID_SLOT});
         }
+
+        UIStateSlot& slot = uiStateSlots_[index];
+        slot.id_ = id;
+        LinkUIStateSlot(index);
+        uiStateHandles_[id] = index | (slot.generation_ << UISTATE_INDEX_BITS);
+        uiStateCount_++;
     }
 
-    return result;
+    UIStateSlot& slot = uiStateSlots_[index];
+    slot.state_ = state;
+    slot.deleter_ = deleter;
+    TouchUIStateSlot(index);
+}
+
+void* GetUIStateP()
+{
+    CollectExpiredUIState();
+
+    auto id = ui::GetCurrentWindow()->IDStack.back();
+    auto it = uiStateHandles_.Find(id);
+    if (it == uiStateHandles_.End())
+        return nullptr;
+
+    unsigned index = GetUIStateSlot(it->second_);
+    if (index == UISTATE_INVALID_SLOT)
+        return nullptr;
+
+    TouchUIStateSlot(index);
+    return uiStateSlots_[index].state_;
 }
 
 void ExpireUIStateP()
 {
-    auto it = uiState_.Find(ui::GetCurrentWindow()->IDStack.back());
-    if (it != uiState_.End())
+    auto it = uiStateHandles_.Find(ui::GetCurrentWindow()->IDStack.back());
+    if (it != uiStateHandles_.End())
     {
-        it->second_.Unset();
-        uiState_.Erase(it);
+        unsigned index = GetUIStateSlot(it->second_);
+        if (index != UISTATE_INVALID_SLOT)
+            FreeUIStateSlot(index);
     }
 }
 
+unsigned GetUIStateCount()
+{
+    return uiStateCount_;
+}
+
+unsigned GetUIStateMemoryUse()
+{
+    return uiStateBytes_ + uiStateSlots_.Capacity() * sizeof(UIStateSlot);
+}
+
 int DoubleClickSelectable(const char* label, bool* p_selected, ImGuiSelectableFlags flags, const ImVec2& size)
 {
     bool wasSelected = p_selected && *p_selected;
@@ -23,6 +23,7 @@
 #pragma once
 
 
+#include <new>
 #include <typeinfo>
 #include <imgui/imgui.h>
 
@@ -30,6 +31,11 @@
 namespace ImGui
 {
 
+/// Allocate memory for ui state object. Small allocations are served from pools of fixed size blocks, size is rounded up
+/// to the nearest power of two size class.
+void* AllocateUIStateMemory(unsigned size);
+/// Return memory allocated by AllocateUIStateMemory() to the pool. Size must be the same as the one used for allocation.
+void FreeUIStateMemory(void* memory, unsigned size);
 /// Set custom user pointer storing UI state at given position of id stack. Optionally pass deleter function which is
 /// responsible for freeing state object when it is no longer used.
 void SetUIStateP(void* state, void(* deleter)(void*) = nullptr);
@@ -38,6 +44,10 @@ void SetUIStateP(void* state, void(* deleter)(void*) = nullptr);
 void* GetUIStateP();
 /// Expire custom ui state at given position if id stack, created with SetUIStateP(). It will be freed immediately.
 void ExpireUIStateP();
+/// Return number of live ui state objects.
+unsigned GetUIStateCount();
+/// Return number of bytes used by ui state storage and ui state objects allocated with AllocateUIStateMemory().
+unsigned GetUIStateMemoryUse();
 /// Get custom user iu state at given position of id stack. If state does not exist then state object will be created.
 /// Using different type at the same id stack position will return new object of that type. Arguments passed to this
 /// function will be passed to constructor of type T.
@@ -48,8 +58,11 @@ T* GetUIState(Args... args)
     T* state = (T*)GetUIStateP();
     if (state == nullptr)
     {
-        state = new T(args...);
-        SetUIStateP(state, [](void* s) { delete (T*)s; });
+        state = new(AllocateUIStateMemory(sizeof(T))) T(args...);
+        SetUIStateP(state, [](void* s) {
+            ((T*)s)->~T();
+            FreeUIStateMemory(s, sizeof(T));
+        });
     }
     ImGui::PopID();
     return state;
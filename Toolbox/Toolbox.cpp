@@ -24,6 +24,10 @@
 #include "SystemUI/Gizmo.h"
 #include "SystemUI/AttributeInspector.h"
 #include "Scene/DebugCameraController.h"
+#include "Scene/NodeClipboard.h"
+#include "Scene/NodeSearchIndex.h"
+#include "Scene/Prefab.h"
+#include "Scene/SceneStatistics.h"
 #include "Common/UndoManager.h"
 
 
@@ -36,6 +40,11 @@ void RegisterToolboxTypes(Context* context)
     context->RegisterFactory<AttributeInspector>();
     context->RegisterFactory<AttributeInspectorWindow>();
     context->RegisterFactory<DebugCameraController>();
+    context->RegisterFactory<NodeClipboard>();
+    context->RegisterFactory<NodeSearchIndex>();
+    context->RegisterFactory<PrefabCache>();
+    PrefabReference::RegisterObject(context);
+    context->RegisterFactory<SceneStatistics>();
     context->RegisterFactory<UndoManager>();
 }
 